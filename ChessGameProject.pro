@@ -1,6 +1,6 @@
 QT       += core gui
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 
 CONFIG += c++17
 
@@ -8,13 +8,13 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(engine.pri)
+
 SOURCES += \
-    src/chess.cpp \
     src/main.cpp \
     src/mainwindow.cpp
 
 HEADERS += \
-    include/chess.h \
     include/mainwindow.h
 
 FORMS += \
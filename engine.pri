@@ -0,0 +1,48 @@
+# Rules engine shared by the GUI and the headless tools under tools/.
+# Pure C++17 — nothing here links against Qt.
+
+INCLUDEPATH += $$PWD/include
+
+# ParallelSearcher and ThreadPool run on std::thread.
+CONFIG += thread
+
+SOURCES += \
+    $$PWD/src/attacks.cpp \
+    $$PWD/src/chess.cpp \
+    $$PWD/src/analysis.cpp \
+    $$PWD/src/transposition.cpp \
+    $$PWD/src/search.cpp \
+    $$PWD/src/history.cpp \
+    $$PWD/src/mappedfile.cpp \
+    $$PWD/src/san.cpp \
+    $$PWD/src/pgn.cpp \
+    $$PWD/src/threadpool.cpp \
+    $$PWD/src/gamedb.cpp \
+    $$PWD/src/nnue.cpp
+
+HEADERS += \
+    $$PWD/include/types.h \
+    $$PWD/include/bitboard.h \
+    $$PWD/include/attacks.h \
+    $$PWD/include/zobrist.h \
+    $$PWD/include/eval.h \
+    $$PWD/include/move.h \
+    $$PWD/include/chess.h \
+    $$PWD/include/analysis.h \
+    $$PWD/include/transposition.h \
+    $$PWD/include/search.h \
+    $$PWD/include/history.h \
+    $$PWD/include/mappedfile.h \
+    $$PWD/include/san.h \
+    $$PWD/include/pgn.h \
+    $$PWD/include/threadpool.h \
+    $$PWD/include/gamedb.h \
+    $$PWD/include/nnue.h
+
+# Debug builds recompute the Zobrist key, the evaluation terms and the NNUE
+# accumulators from scratch and assert they match the incremental ones.
+CONFIG(debug, debug|release): DEFINES += CHESS_VERIFY_HASH CHESS_VERIFY_EVAL CHESS_VERIFY_NNUE
+
+# Slider lookups use PEXT instead of magic multiplication when the compiler
+# targets BMI2 (e.g. QMAKE_CXXFLAGS += -mbmi2 or -march=native). Define
+# CHESS_NO_PEXT to keep magics on CPUs where PEXT is microcoded.
@@ -0,0 +1,23 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "chess.h"
+#include <cstdint>
+
+// Everything the UI shows about a position — check, game over, the legal
+// move list — computed in one pass so it can be produced off the GUI thread
+// and cached by Zobrist key.
+struct PositionAnalysis {
+    std::uint64_t hash       = 0;
+    PieceColor    toMove     = PieceColor::White;
+    int           kingSquare = -1;   // side to move's king
+    bool          inCheck    = false;
+    bool          checkmate  = false;
+    bool          stalemate  = false;
+    MoveList      moves;             // all legal moves, promotions included
+};
+
+// Reads the game only, so it is safe on a private copy in a worker thread.
+PositionAnalysis analyzePosition(const ChessGame& game);
+
+#endif // ANALYSIS_H
@@ -0,0 +1,101 @@
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include "bitboard.h"
+#include <array>
+#if defined(__BMI2__) && !defined(CHESS_NO_PEXT)
+#include <immintrin.h>
+#define CHESS_USE_PEXT 1
+#endif
+
+// Attack lookups: leapers and pawns come from compile-time tables, sliders
+// from magic bitboards (or PEXT when the build targets BMI2). Any query is
+// a couple of loads.
+namespace attacks {
+
+template <typename F>
+constexpr std::array<Bitboard, 64> perSquare(F f) {
+    std::array<Bitboard, 64> t{};
+    for (int sq = 0; sq < 64; ++sq) t[sq] = f(bit(sq));
+    return t;
+}
+
+inline constexpr std::array<Bitboard, 64> kKnight = perSquare(knightAttacks);
+inline constexpr std::array<Bitboard, 64> kKing   = perSquare(kingAttacks);
+inline constexpr std::array<std::array<Bitboard, 64>, 2> kPawn = {
+    perSquare([](Bitboard b) { return pawnAttacks(PieceColor::White, b); }),
+    perSquare([](Bitboard b) { return pawnAttacks(PieceColor::Black, b); }),
+};
+
+// One slider square: relevant-occupancy mask and its slice of the shared table.
+struct Magic {
+    Bitboard        mask;
+    Bitboard        magic;
+    const Bitboard* table;
+    unsigned        shift;
+
+    unsigned index(Bitboard occupied) const {
+#ifdef CHESS_USE_PEXT
+        return unsigned(_pext_u64(occupied, mask));
+#else
+        return unsigned(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+// Filled by a static initialiser in attacks.cpp before main() runs.
+extern std::array<Magic, 64> gRookMagics;
+extern std::array<Magic, 64> gBishopMagics;
+extern std::array<std::array<Bitboard, 64>, 64> gBetween;   // squares strictly between
+extern std::array<std::array<Bitboard, 64>, 64> gLine;      // full line through both
+
+inline Bitboard knight(int sq)              { return kKnight[sq]; }
+inline Bitboard king(int sq)                { return kKing[sq]; }
+inline Bitboard pawn(PieceColor c, int sq)  { return kPawn[int(c)][sq]; }
+
+inline Bitboard rook(int sq, Bitboard occupied) {
+    const Magic& m = gRookMagics[sq];
+    return m.table[m.index(occupied)];
+}
+inline Bitboard bishop(int sq, Bitboard occupied) {
+    const Magic& m = gBishopMagics[sq];
+    return m.table[m.index(occupied)];
+}
+inline Bitboard queen(int sq, Bitboard occupied) {
+    return rook(sq, occupied) | bishop(sq, occupied);
+}
+
+// Empty unless a and b share a rank, file or diagonal.
+inline Bitboard between(int a, int b) { return gBetween[a][b]; }
+inline Bitboard line(int a, int b)    { return gLine[a][b]; }
+
+// Pieces of colour 'by' attacking sq, given the occupancy 'occupied'.
+inline Bitboard attackersTo(const BoardState& s, int sq, PieceColor by, Bitboard occupied) {
+    Bitboard queens = s.of(by, PieceType::Queen);
+    return (pawn(opponent(by), sq)  & s.of(by, PieceType::Pawn))
+         | (knight(sq)              & s.of(by, PieceType::Knight))
+         | (king(sq)                & s.of(by, PieceType::King))
+         | (bishop(sq, occupied)    & (s.of(by, PieceType::Bishop) | queens))
+         | (rook(sq, occupied)      & (s.of(by, PieceType::Rook)   | queens));
+}
+
+// Is sq attacked by 'by'? Works backwards from the target: a piece of type T
+// attacks sq exactly when a T standing on sq would attack it. Leapers are
+// tested first and the first hit returns; nothing is generated or allocated.
+// 'occupied' lets callers ask about hypothetical boards (e.g. king removed).
+inline bool isAttacked(const BoardState& s, int sq, PieceColor by, Bitboard occupied) {
+    if (pawn(opponent(by), sq) & s.of(by, PieceType::Pawn))   return true;
+    if (knight(sq)             & s.of(by, PieceType::Knight)) return true;
+    if (king(sq)               & s.of(by, PieceType::King))   return true;
+    Bitboard queens = s.of(by, PieceType::Queen);
+    if (bishop(sq, occupied) & (s.of(by, PieceType::Bishop) | queens)) return true;
+    return rook(sq, occupied) & (s.of(by, PieceType::Rook) | queens);
+}
+
+inline bool isAttacked(const BoardState& s, int sq, PieceColor by) {
+    return isAttacked(s, sq, by, s.occupied);
+}
+
+} // namespace attacks
+
+#endif // ATTACKS_H
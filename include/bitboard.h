@@ -0,0 +1,173 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "types.h"
+#include <array>
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// One bit per square, a1 = bit 0, h1 = bit 7, a8 = bit 56 (square = row*8 + col,
+// matching Position where row 0 is White's back rank).
+using Bitboard = std::uint64_t;
+
+constexpr Bitboard kFileA = 0x0101010101010101ULL;
+constexpr Bitboard kFileB = kFileA << 1;
+constexpr Bitboard kFileG = kFileA << 6;
+constexpr Bitboard kFileH = kFileA << 7;
+constexpr Bitboard kRank1 = 0xFFULL;
+constexpr Bitboard kRank2 = kRank1 << 8;
+constexpr Bitboard kRank7 = kRank1 << 48;
+constexpr Bitboard kRank8 = kRank1 << 56;
+
+constexpr Bitboard bit(int sq)              { return Bitboard(1) << sq; }
+constexpr int      squareOf(Position p)     { return p.row * 8 + p.col; }
+constexpr Position positionOf(int sq)       { return Position(sq >> 3, sq & 7); }
+
+inline int lsb(Bitboard b) {
+#if defined(_MSC_VER)
+    unsigned long i; _BitScanForward64(&i, b); return int(i);
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+inline int popLsb(Bitboard& b) { int sq = lsb(b); b &= b - 1; return sq; }
+
+inline int popCount(Bitboard b) {
+#if defined(_MSC_VER)
+    return int(__popcnt64(b));
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+// ── set-wise attack generation (shifts and masks only) ────────────────────────
+
+constexpr Bitboard shiftBy(Bitboard b, int s) { return s > 0 ? b << s : b >> -s; }
+
+// Kogge-Stone occluded fill: every square reached from 'gen' in direction 's'
+// before (and including) the first blocker. 'wrap' holds the squares a step in
+// this direction would land on after wrapping round the board edge.
+constexpr Bitboard slideAttacks(Bitboard gen, Bitboard empty, int s, Bitboard wrap) {
+    Bitboard pro = empty & ~wrap;
+    gen |= pro & shiftBy(gen, s);
+    pro &= shiftBy(pro, s);
+    gen |= pro & shiftBy(gen, 2 * s);
+    pro &= shiftBy(pro, 2 * s);
+    gen |= pro & shiftBy(gen, 4 * s);
+    return shiftBy(gen, s) & ~wrap;
+}
+
+constexpr Bitboard rookAttacks(Bitboard rooks, Bitboard occupied) {
+    Bitboard empty = ~occupied;
+    return slideAttacks(rooks, empty,  8, 0)      | slideAttacks(rooks, empty, -8, 0)
+         | slideAttacks(rooks, empty,  1, kFileA) | slideAttacks(rooks, empty, -1, kFileH);
+}
+
+constexpr Bitboard bishopAttacks(Bitboard bishops, Bitboard occupied) {
+    Bitboard empty = ~occupied;
+    return slideAttacks(bishops, empty,  9, kFileA) | slideAttacks(bishops, empty,  7, kFileH)
+         | slideAttacks(bishops, empty, -7, kFileA) | slideAttacks(bishops, empty, -9, kFileH);
+}
+
+constexpr Bitboard knightAttacks(Bitboard knights) {
+    Bitboard l1 = (knights >> 1) & ~kFileH, l2 = (knights >> 2) & ~(kFileG | kFileH);
+    Bitboard r1 = (knights << 1) & ~kFileA, r2 = (knights << 2) & ~(kFileA | kFileB);
+    Bitboard h1 = l1 | r1, h2 = l2 | r2;
+    return (h1 << 16) | (h1 >> 16) | (h2 << 8) | (h2 >> 8);
+}
+
+constexpr Bitboard kingAttacks(Bitboard kings) {
+    Bitboard side = ((kings << 1) & ~kFileA) | ((kings >> 1) & ~kFileH);
+    Bitboard row  = kings | side;
+    return side | (row << 8) | (row >> 8);
+}
+
+constexpr Bitboard pawnAttacks(PieceColor c, Bitboard pawns) {
+    return c == PieceColor::White
+        ? ((pawns << 9) & ~kFileA) | ((pawns << 7) & ~kFileH)
+        : ((pawns >> 7) & ~kFileA) | ((pawns >> 9) & ~kFileH);
+}
+
+// ── position ──────────────────────────────────────────────────────────────────
+
+enum CastlingRight : std::uint8_t {
+    WhiteKingside  = 1,
+    WhiteQueenside = 2,
+    BlackKingside  = 4,
+    BlackQueenside = 8,
+    AllCastling    = 15
+};
+
+// Index into BoardState::pieces: White Pawn..King = 0..5, Black = 6..11.
+constexpr int pieceIndex(PieceColor c, PieceType t) { return int(c) * 6 + int(t) - 1; }
+
+// The whole rules-relevant position in two cache lines: 12 piece sets, the
+// two colour sets, their union, and the non-board state.
+struct alignas(64) BoardState {
+    std::array<Bitboard, 12> pieces{};
+    std::array<Bitboard, 2>  colors{};
+    Bitboard     occupied   = 0;
+    PieceColor   sideToMove = PieceColor::White;
+    std::uint8_t castling   = 0;    // CastlingRight bits
+    std::int8_t  epSquare   = -1;   // square a pawn can capture INTO, or -1
+    std::uint16_t halfmoveClock  = 0;   // plies since the last capture or pawn move
+    std::uint16_t fullmoveNumber = 1;   // starts at 1, incremented after Black moves
+
+    Bitboard of(PieceColor c, PieceType t) const { return pieces[pieceIndex(c, t)]; }
+    Bitboard of(PieceColor c)              const { return colors[int(c)]; }
+    int kingSquare(PieceColor c) const {
+        Bitboard k = of(c, PieceType::King);
+        return k ? lsb(k) : -1;
+    }
+
+    void put(PieceColor c, PieceType t, int sq) {
+        pieces[pieceIndex(c, t)] |= bit(sq);
+        colors[int(c)]           |= bit(sq);
+        occupied                 |= bit(sq);
+    }
+    void remove(PieceColor c, PieceType t, int sq) {
+        pieces[pieceIndex(c, t)] &= ~bit(sq);
+        colors[int(c)]           &= ~bit(sq);
+        occupied                 &= ~bit(sq);
+    }
+    void move(PieceColor c, PieceType t, int from, int to) {
+        Bitboard ft = bit(from) | bit(to);
+        pieces[pieceIndex(c, t)] ^= ft;
+        colors[int(c)]           ^= ft;
+        occupied                 ^= ft;
+    }
+
+    // Position identity: the move counters do not take part.
+    bool operator==(const BoardState& o) const {
+        return pieces == o.pieces && sideToMove == o.sideToMove &&
+               castling == o.castling && epSquare == o.epSquare;
+    }
+    bool operator!=(const BoardState& o) const { return !(*this == o); }
+
+    PieceType typeAt(int sq) const {
+        for (int i = 0; i < 12; ++i)
+            if (pieces[i] & bit(sq)) return PieceType(i % 6 + 1);
+        return PieceType::None;
+    }
+
+    // Every square attacked by 'c' (set-wise, no per-piece loop over rays),
+    // with sliders blocked by 'occ' — e.g. the board minus a king, so the
+    // squares behind it along a checking ray count as attacked.
+    Bitboard attacksBy(PieceColor c, Bitboard occ) const {
+        Bitboard rq = of(c, PieceType::Rook)   | of(c, PieceType::Queen);
+        Bitboard bq = of(c, PieceType::Bishop) | of(c, PieceType::Queen);
+        return pawnAttacks(c, of(c, PieceType::Pawn))
+             | knightAttacks(of(c, PieceType::Knight))
+             | kingAttacks(of(c, PieceType::King))
+             | rookAttacks(rq, occ)
+             | bishopAttacks(bq, occ);
+    }
+    Bitboard attacksBy(PieceColor c) const { return attacksBy(c, occupied); }
+};
+
+static_assert(sizeof(BoardState) <= 128, "BoardState should fit in two cache lines");
+
+#endif // BITBOARD_H
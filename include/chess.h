@@ -1,78 +1,181 @@
 #ifndef CHESS_H
 #define CHESS_H
 
+#include "types.h"
+#include "bitboard.h"
+#include "move.h"
+#include "eval.h"
 #include <vector>
-#include <memory>
 #include <array>
-#include <QDebug>
-
-enum class PieceType { None, Pawn, Rook, Knight, Bishop, Queen, King };
-enum class PieceColor { White, Black, None };
-
-struct Position {
-    int row, col;
-    Position(int r = -1, int c = -1) : row(r), col(c) {}
-    bool operator==(const Position& o) const { return row == o.row && col == o.col; }
-    bool isValid() const { return row >= 0 && row < 8 && col >= 0 && col < 8; }
-};
+#include <string>
+#include <string_view>
 
+// A piece as the GUI sees it. Pieces are plain values held in a fixed pool
+// inside ChessGame; getPieceAt() hands out pointers into that pool, which
+// stay valid for the life of the game but may show another piece after a
+// move or a setup.
 class Piece {
 public:
+    Piece() = default;
     Piece(PieceType type, PieceColor color, Position position)
-        : type_(type), color_(color), position_(position), hasMoved_(false) {}
-    virtual ~Piece() = default;
+        : type_(type), color_(color), square_(std::uint8_t(squareOf(position))) {}
 
     PieceType  getType()     const { return type_; }
     PieceColor getColor()    const { return color_; }
-    Position   getPosition() const { return position_; }
+    Position   getPosition() const { return positionOf(square_); }
     bool       hasMoved()    const { return hasMoved_; }
 
-    void setPosition(Position pos) { position_ = pos; hasMoved_ = true; }
+    // Squares the piece's own movement rule reaches on board by walking
+    // rays, ignoring check, castling and en passant. The engine generates
+    // moves from BoardState; this is only kept as a reference point.
+    std::vector<Position> getPossibleMoves(
+        const std::array<std::array<const Piece*, 8>, 8>& board) const;
 
-    virtual std::vector<Position> getPossibleMoves(
-        const std::array<std::array<Piece*, 8>, 8>& board) const = 0;
-    virtual std::unique_ptr<Piece> clone() const = 0;
+private:
+    friend class ChessGame;   // make/unmake move pieces between squares directly
 
-protected:
-    PieceType  type_;
-    PieceColor color_;
-    Position   position_;
-    bool       hasMoved_;
+    PieceType    type_     = PieceType::None;
+    PieceColor   color_    = PieceColor::None;
+    std::uint8_t square_   = 0;
+    bool         hasMoved_ = false;
+};
+
+// The pieces a move took off and put on the board, in the order it did,
+// for evaluators that follow the position piece by piece (nnue.h). A
+// capturing promotion makes the most: the capture, the pawn's move as off
+// and on, then the pawn off again and the new piece on.
+struct BoardChanges {
+    static constexpr int          kMax   = 5;
+    static constexpr std::uint8_t kPutOn = 0x80;   // flag in piece[]; otherwise taken off
+
+    std::uint8_t count = 0;
+    std::uint8_t piece[kMax];    // pieceIndex(), | kPutOn
+    std::uint8_t square[kMax];
+
+    void record(PieceColor c, PieceType t, int sq, bool putOn) {
+        piece[count]    = std::uint8_t(pieceIndex(c, t) | (putOn ? kPutOn : 0));
+        square[count++] = std::uint8_t(sq);
+    }
+};
+
+// Everything unmakeMove needs to put back what makeMove changed.
+// Captured (and promoted-away) pieces keep their pool slots, off the board,
+// so the record only names them and a make/unmake pair never touches the
+// heap.
+struct MoveUndo {
+    static constexpr std::uint8_t kNoPiece = 0xFF;
+
+    Position from, to;
+    std::uint8_t captured     = kNoPiece;   // pool slot of the piece taken by this move
+    std::uint8_t promotedPawn = kNoPiece;   // pool slot of the pawn replaced by the promotion piece
+    std::int8_t  prevEpSquare = -1;
+    std::uint8_t prevCastling = 0;
+    std::uint64_t prevHash    = 0;
+    std::uint64_t prevHistoryKey = 0;   // repetition ring entry this move overwrote
+    eval::Terms   prevEval;
+    std::uint16_t prevHalfmoveClock = 0;
+    bool     movedHadMoved = false;
+    bool     rookHadMoved  = false;
+    bool     isCastling    = false;
+    BoardChanges changes;   // filled by makeMove, not needed by unmakeMove
 };
 
 class ChessGame {
 public:
+    // Trivially copyable: every member is inline, so a copy is a memcpy.
     ChessGame();
-    ChessGame(const ChessGame& other);
-    ChessGame& operator=(const ChessGame& other);
 
     void initializeBoard();
+
+    // FEN import/export: placement, side to move, castling rights, en
+    // passant square and both move counters. parseFEN only fills a
+    // BoardState and never allocates; fromFEN also rebuilds the piece view.
+    // Missing trailing fields default to "- - 0 1". More than 16 pieces a
+    // side is malformed; on malformed input the target is left untouched
+    // and false is returned.
+    static bool parseFEN(std::string_view fen, BoardState& out);
+    bool        fromFEN(std::string_view fen);
+    std::string toFEN() const;
+
     bool movePiece(Position from, Position to);
     bool isCheckmate(PieceColor color) const;
     bool isStalemate(PieceColor color) const;
     bool isKingInCheck(PieceColor color) const;
 
-    PieceColor getCurrentTurn() const { return currentTurn_; }
-    Piece*     getPieceAt(Position pos) const;
+    // In-place move application for search and analysis.
+    // makeMove trusts the caller: (from, to) must be a pseudo-legal move for
+    // the side to move. PieceType::None as promotion leaves a pawn on the
+    // last rank, which is enough for check tests. Promotions must be
+    // unmade in reverse order, as search and MoveHistory do.
+    void makeMove(Position from, Position to, MoveUndo& undo,
+                  PieceType promotion = PieceType::Queen);
+    void makeMove(Move move, MoveUndo& undo);
+    void unmakeMove(MoveUndo& undo);
+
+    // Bulk legal move generation into a caller-owned fixed-capacity list.
+    // Captures (en passant and capturing promotions included) and quiets
+    // partition the full legal move set.
+    void generateLegalMoves(MoveList& list) const;
+    void generateCaptures(MoveList& list) const;
+    void generateQuiets(MoveList& list) const;
+
+    // Draw rules, cheap enough for every search node. repetitions() counts
+    // earlier occurrences of the current position (same Zobrist key), only
+    // looking back over plies since the last capture or pawn move and
+    // stopping once limit is reached: threefold repetition is
+    // repetitions() >= 2. The fifty-move rule is applied as soon as the
+    // halfmove clock reaches 100, without waiting for a claim.
+    int  repetitions(int limit = 2) const;
+    bool isFiftyMoveDraw() const { return state_.halfmoveClock >= 100; }
+    bool isInsufficientMaterial() const;
+    enum class DrawReason { None, Repetition, FiftyMoves, InsufficientMaterial };
+    DrawReason drawReason() const;   // for adjudication; checkmate takes precedence
+
+    PieceColor getCurrentTurn() const { return state_.sideToMove; }
+    const BoardState& state() const  { return state_; }
+    std::uint64_t     hash()  const  { return hash_; }   // Zobrist key of state_
+    const eval::Terms& evalTerms() const { return eval_; }   // eval::termsOf(state_)
+    const Piece* getPieceAt(Position pos) const;
     std::vector<Position> getValidMoves(Position pos) const;
 
 private:
-    std::vector<std::unique_ptr<Piece>>   pieces_;
-    std::array<std::array<Piece*, 8>, 8>  board_;
-    PieceColor currentTurn_;
-    Position   whiteKingPos_;
-    Position   blackKingPos_;
-    Position   enPassantTarget_;   // square a pawn can capture INTO via en passant
+    // state_ is the authoritative position and drives all move generation.
+    // The pool mirrors it as Piece values for getPieceAt() callers: setup
+    // fills the first slots, and each promotion takes the next one (a pawn
+    // promotes at most once, so 16 spare slots always suffice). Captured
+    // and promoted-away pieces stay in their slots, off the board, for
+    // unmakeMove to put back. slotAt_ maps squares to slots.
+    static constexpr int kPoolSize = 32 + 16;
+    BoardState                            state_;
+    std::array<Piece, kPoolSize>          pieces_{};
+    std::array<std::uint8_t, 64>          slotAt_{};
+    std::uint8_t                          used_ = 0;   // slots handed out
+    std::uint64_t                         hash_ = 0;   // kept in step with state_
+    eval::Terms                           eval_;       // likewise
+
+    // Keys of the positions moves were made from, by ply. A position more
+    // than 100 plies back can never repeat: a capture or pawn move came in
+    // between, or the fifty-move rule has already ended the game; if play
+    // goes on anyway, repetitions() stops at the oldest key kept.
+    static constexpr int kHistorySize = 128;
+    std::array<std::uint64_t, kHistorySize> history_{};
+    int                                     plies_ = 0;   // moves made since setup
 
     // --- helpers ---
     bool isSquareAttackedBy(Position sq, PieceColor attacker) const;
-    bool isMoveLegal(Position from, Position to) const;
     bool hasLegalMoves(PieceColor color) const;
-    void removePieceAt(Position pos);
-    void handleCastling(Position from, Position to, Piece* king);
-    void handleEnPassant(Position from, Position to, Piece* pawn);
-    void handlePawnPromotion(Position pos);
-    std::vector<Position> getRawMoves(const Piece* piece) const;
+    void rebuildPieces();
+    std::uint8_t takePieceAt(Position pos);
+    void handleCastling(Position from, Position to, std::uint8_t king, MoveUndo& undo);
+    void handleEnPassant(Position from, Position to, std::uint8_t pawn, MoveUndo& undo);
+    void handlePawnPromotion(Position pos, PieceType promotion, MoveUndo& undo);
+    enum class GenKind { All, Captures, Quiets };
+    void generate(MoveList& list, GenKind kind, PieceColor us,
+                  Bitboard fromMask = ~Bitboard(0), bool firstOnly = false) const;
+    void verifyHash() const;
+    void verifyEval() const;
+    Bitboard pseudoTargets(int sq) const;
+    Bitboard castlingTargets(int kingSq, PieceColor us) const;
 };
 
 #endif // CHESS_H
\ No newline at end of file
@@ -0,0 +1,130 @@
+#ifndef GAMEDB_H
+#define GAMEDB_H
+
+#include "chess.h"
+#include "mappedfile.h"
+#include "pgn.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Compact binary game database: "<base>.bin" holds the games, "<base>.idx"
+// a fixed-size entry per game plus a table of distinct strings. Both files
+// are memory-mapped on read; opening checks the index in one pass, and any
+// game is then reached with one index lookup.
+//
+// A move is stored as one byte: its rank among the legal moves of the
+// position, ordered by 16-bit Move code, which does not depend on the order
+// the generator happens to produce them in. Tag names and values are
+// stored once in the string table and referenced by varint ids, so player,
+// event and site names repeated across games cost a few bytes each.
+//
+// .bin: "CGDB" u32 version, then per game: varint tag count, that many
+//       (name id, value id) varint pairs, then one byte per ply.
+// .idx: "CGDX" u32 version, u64 game count, u64 string count, u64 offset of
+//       the string offsets; IndexEntry per game; u64 offset per string
+//       (plus one end offset) relative to the string bytes that follow.
+// Integers are little-endian.
+
+enum class GameResult : std::uint8_t { Unknown, WhiteWins, BlackWins, Draw };
+
+GameResult       resultFromText(std::string_view text);
+std::string_view resultText(GameResult result);
+
+namespace gamedb {
+
+constexpr std::uint32_t kVersion = 1;
+
+struct IndexEntry {
+    std::uint64_t offset;     // record position in .bin
+    std::uint32_t plies;
+    std::uint16_t tagCount;
+    GameResult    result;
+    std::uint8_t  reserved;
+};
+static_assert(sizeof(IndexEntry) == 16, "index entries are 16 bytes on disk");
+
+struct IndexHeader {
+    char          magic[4];
+    std::uint32_t version;
+    std::uint64_t games;
+    std::uint64_t strings;
+    std::uint64_t stringOffsets;   // file offset of the string offset table
+};
+static_assert(sizeof(IndexHeader) == 32, "index header is 32 bytes on disk");
+
+} // namespace gamedb
+
+class GameDatabaseWriter {
+public:
+    GameDatabaseWriter() = default;
+    ~GameDatabaseWriter() { close(); }
+    GameDatabaseWriter(const GameDatabaseWriter&)            = delete;
+    GameDatabaseWriter& operator=(const GameDatabaseWriter&) = delete;
+
+    bool open(const std::string& basePath);
+
+    // Appends a game played from the FEN tag (or the start position). The
+    // result comes from the Result tag. False, with nothing written, if the
+    // FEN is invalid, a move is illegal or the game has over 65535 tags.
+    bool add(const std::vector<PgnTag>& tags, const std::vector<Move>& moves);
+
+    // Writes the index; called by the destructor if not before.
+    bool close();
+
+    std::uint64_t games() const { return entries_.size(); }
+    const std::string& error() const { return error_; }
+
+private:
+    std::uint32_t intern(std::string_view s);
+
+    FILE*                                          bin_ = nullptr;
+    std::string                                    indexPath_;
+    std::uint64_t                                  offset_ = 0;
+    std::vector<gamedb::IndexEntry>                entries_;
+    std::unordered_map<std::string, std::uint32_t> ids_;
+    std::vector<const std::string*>                strings_;   // by id, keys of ids_
+    std::string                                    record_;    // scratch
+    std::string                                    key_;       // scratch
+    ChessGame                                      game_;
+    std::string                                    error_;
+};
+
+class GameDatabase {
+public:
+    bool open(const std::string& basePath);
+    void close();
+
+    std::size_t size() const { return size_t(header_ ? header_->games : 0); }
+    const std::string& error() const { return error_; }
+
+    // All O(1) in the number of games.
+    const gamedb::IndexEntry& entry(std::size_t game) const { return entries_[game]; }
+    GameResult       result(std::size_t game) const { return entries_[game].result; }
+    int              plies(std::size_t game)  const { return int(entries_[game].plies); }
+    std::string_view stringAt(std::uint64_t id) const;
+
+    // Tag views point into the mapped string table; they stay valid until
+    // close(). out is cleared first.
+    bool tags(std::size_t game, std::vector<PgnTag>& out) const;
+
+    // Replays the game into game and appends its moves to out (cleared
+    // first). False if the stored data does not decode.
+    bool moves(std::size_t game, ChessGame& board, std::vector<Move>& out) const;
+
+private:
+    bool fail(std::string message);
+    const char* recordEnd(std::size_t game) const;
+
+    MappedFile                 bin_, idx_;
+    const gamedb::IndexHeader* header_  = nullptr;
+    const gamedb::IndexEntry*  entries_ = nullptr;
+    const std::uint64_t*       stringOffsets_ = nullptr;
+    const char*                stringBytes_   = nullptr;
+    std::string                error_;
+};
+
+#endif // GAMEDB_H
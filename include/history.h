@@ -0,0 +1,36 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "chess.h"
+#include <vector>
+
+// The moves of a game, with undo, redo and jumping to any ply in place.
+//
+// Every move keeps its 16-bit Move and, while it is on the board, its
+// MoveUndo record. Stepping back unmakes and stepping forward makes again,
+// so navigation costs one make/unmake per ply and never copies the
+// ChessGame; memory grows with the number of moves only. Undone moves stay
+// in the line until a different move is played over them.
+class MoveHistory {
+public:
+    // Forgets the line; the game's current position becomes ply 0.
+    void clear();
+
+    // Plays a legal move at the current ply. If it is the line's next move
+    // the rest of the line is kept, as with redo; otherwise it replaces it.
+    void play(ChessGame& game, Move move);
+
+    bool undo(ChessGame& game);
+    bool redo(ChessGame& game);
+    void jumpTo(ChessGame& game, int ply);   // clamped to [0, length()]
+
+    int  ply()    const { return int(undo_.size()); }
+    int  length() const { return int(line_.size()); }
+    const std::vector<Move>& line() const { return line_; }
+
+private:
+    std::vector<Move>     line_;
+    std::vector<MoveUndo> undo_;   // one per ply currently on the board
+};
+
+#endif // HISTORY_H
@@ -2,8 +2,16 @@
 #define MAINWINDOW_H
 
 #include "chess.h"
+#include "analysis.h"
+#include "search.h"
+#include "history.h"
 #include <QMainWindow>
+#include <QPixmap>
 #include <QTimer>
+#include <QFutureWatcher>
+#include <unordered_map>
+
+class QAction;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -12,25 +20,86 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // Frame-time measurement mode (--frame-times): logs paintEvent cost.
+    void setFrameTiming(bool on) { frameTiming = on; }
+
 protected:
     void paintEvent(QPaintEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
 
 private slots:
     void updateGameStatus();
+    void onAnalysisReady();
+    void onEngineMove();
+    void takeBack();
+    void stepForward();
+    void jumpToPly(int ply);
 
 private:
     ChessGame             game;
+    MoveHistory           history;   // every move played; undo/redo/jump in place
     Position              selectedPos;
     std::vector<Position> validMoves;
     std::vector<Position> captureMoves;   // ← NEW: subset of validMoves that capture an enemy
     QTimer*               updateTimer;
     const int             squareSize = 70;
 
+    // The 12 piece images decoded once and pre-scaled to the screen's
+    // device pixel ratio: row = colour, column = PieceType - 1.
+    QPixmap pieceAtlas;
+    int     atlasCell = 0;   // sprite size in device pixels
+    // Border, squares and coordinates, rendered once.
+    QPixmap boardLayer;
+    qreal   layerDpr  = 0;   // ratio the atlas and board layer were built for
+
+    // What is currently on screen, as square sets; refreshBoard() diffs the
+    // next view against it and invalidates only the squares that changed.
+    struct BoardView {
+        Bitboard pieces[12] = {};   // by pieceIndex(), as in BoardState
+        Bitboard selected = 0, moves = 0, captures = 0, check = 0;
+    };
+    BoardView drawnView;
+
+    bool    frameTiming  = false;
+    int     frameCount   = 0;
+    qint64  frameNsTotal = 0;
+    qint64  frameNsMax   = 0;
+
+    // Check / game-over / legal-move facts for each position seen, computed
+    // by analyzePosition() on a QtConcurrent worker and keyed by hash().
+    // Painting and input only read this cache; nothing here runs the engine
+    // on the GUI thread. It is emptied once it holds kAnalysisCacheSize
+    // positions, so a long session does not grow it without bound.
+    std::unordered_map<std::uint64_t, PositionAnalysis> analysisCache;
+    const PositionAnalysis*            analysis = nullptr;   // current position, once known
+    QFutureWatcher<PositionAnalysis>*  analysisWatcher;
+
+    // "Computer plays Black": the search runs on a QtConcurrent worker with
+    // its own copy of the game; the GUI thread only applies the result.
+    QAction*                      computerBlackAction;
+    TranspositionTable            engineTable{16};   // MB; kept across moves
+    Searcher                      searcher{&engineTable};
+    QFutureWatcher<SearchResult>* engineWatcher;
+    // Bumped by stopEngine(); a result whose search started under an older
+    // generation was stopped or is for another position, and is never played.
+    std::uint64_t                 engineGeneration   = 0;
+    std::uint64_t                 searchedGeneration = 0;   // of the running search
+
     void drawBoard(QPainter& p);
-    void drawPieces(QPainter& p);
-    void drawHighlights(QPainter& p);
+    void drawPieces(QPainter& p, Bitboard visible);
+    void drawHighlights(QPainter& p, Bitboard visible);
     void drawCoordinates(QPainter& p);    // ← NEW: a-h / 1-8 labels on the border
+    void buildPieceAtlas();
+    void buildBoardLayer();
+    BoardView currentView() const;
+    void refreshBoard();
+    const PositionAnalysis* currentAnalysis() const;
+    void showAnalysis(const PositionAnalysis& a);
+    bool engineToMove() const;
+    void startEngine();
+    void stopEngine();
+    void playMove(Move m);
+    void positionChanged();
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory map of a whole file. Pages are read in on demand and can
+// be dropped again by the OS at any time, so resident memory stays flat no
+// matter how large the file is.
+class MappedFile {
+public:
+    // Read-ahead hint: archives are streamed front to back, databases are
+    // read wherever the requested game happens to be.
+    enum class Access { Sequential, Random };
+
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path, Access access = Access::Sequential) { open(path, access); }
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Replaces any current mapping. An empty file opens successfully with
+    // an empty view. On failure error() says why.
+    bool open(const std::string& path, Access access = Access::Sequential);
+    void close();
+
+    bool               isOpen() const { return open_; }
+    std::string_view   view()   const { return { data_, size_ }; }
+    std::size_t        size()   const { return size_; }
+    const std::string& error()  const { return error_; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool        open_ = false;
+    std::string error_;
+};
+
+#endif // MAPPEDFILE_H
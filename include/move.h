@@ -0,0 +1,92 @@
+#ifndef MOVE_H
+#define MOVE_H
+
+#include "types.h"
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Move flags, stored in the top four bits of a Move. Bit 2 marks captures,
+// bit 3 promotions; the low two bits of a promotion pick the piece.
+enum MoveFlag : std::uint16_t {
+    Quiet              = 0,
+    DoublePush         = 1,
+    KingCastle         = 2,
+    QueenCastle        = 3,
+    Capture            = 4,
+    EnPassant          = 5,
+    PromoKnight        = 8,
+    PromoBishop        = 9,
+    PromoRook          = 10,
+    PromoQueen         = 11,
+    PromoKnightCapture = 12,
+    PromoBishopCapture = 13,
+    PromoRookCapture   = 14,
+    PromoQueenCapture  = 15
+};
+
+// 16-bit move: from square (bits 0-5), to square (6-11), flags (12-15).
+// Squares use the bitboard numbering (row * 8 + col).
+class Move {
+public:
+    Move() = default;   // left uninitialised so MoveList costs nothing to create
+    constexpr Move(int from, int to, int flags = Quiet)
+        : data_(std::uint16_t(from | (to << 6) | (flags << 12))) {}
+
+    static constexpr Move none()                   { return Move(0, 0); }
+    static constexpr Move fromRaw(std::uint16_t r) { Move m(0, 0); m.data_ = r; return m; }
+
+    constexpr int  from()  const { return data_ & 63; }
+    constexpr int  to()    const { return (data_ >> 6) & 63; }
+    constexpr int  flags() const { return data_ >> 12; }
+    constexpr std::uint16_t raw() const { return data_; }
+
+    constexpr bool isCapture()   const { return flags() & Capture; }
+    constexpr bool isPromotion() const { return flags() & PromoKnight; }
+    constexpr bool isCastle()    const { return flags() == KingCastle || flags() == QueenCastle; }
+    constexpr bool isEnPassant() const { return flags() == EnPassant; }
+    constexpr PieceType promotion() const {
+        if (!isPromotion()) return PieceType::None;
+        constexpr PieceType kPieces[] = { PieceType::Knight, PieceType::Bishop,
+                                          PieceType::Rook,   PieceType::Queen };
+        return kPieces[flags() & 3];
+    }
+
+    constexpr Position fromPos() const { return Position(from() >> 3, from() & 7); }
+    constexpr Position toPos()   const { return Position(to() >> 3, to() & 7); }
+
+    constexpr bool operator==(Move o) const { return data_ == o.data_; }
+    constexpr bool operator!=(Move o) const { return data_ != o.data_; }
+
+    // Coordinate notation, e.g. "e2e4", "e7e8q".
+    std::string uci() const {
+        std::string s;
+        s += char('a' + (from() & 7)); s += char('1' + (from() >> 3));
+        s += char('a' + (to() & 7));   s += char('1' + (to() >> 3));
+        if (isPromotion()) s += "nbrq"[flags() & 3];
+        return s;
+    }
+
+private:
+    std::uint16_t data_;
+};
+
+// Fixed-capacity move buffer meant to live on the stack. No position has
+// more than 218 legal moves.
+struct MoveList {
+    std::array<Move, 256> moves;
+    int                   count = 0;
+
+    void  add(Move m)               { moves[count++] = m; }
+    void  clear()                   { count = 0; }
+    int   size()  const             { return count; }
+    bool  empty() const             { return count == 0; }
+    Move  operator[](int i) const   { return moves[i]; }
+    Move& operator[](int i)         { return moves[i]; }
+    Move*       begin()             { return moves.data(); }
+    Move*       end()               { return moves.data() + count; }
+    const Move* begin() const       { return moves.data(); }
+    const Move* end()   const       { return moves.data() + count; }
+};
+
+#endif // MOVE_H
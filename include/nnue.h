@@ -0,0 +1,128 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "chess.h"
+#include "mappedfile.h"
+#include <cstdint>
+#include <string>
+
+// NNUE evaluation: an efficiently updatable neural network.
+//
+//   HalfKP inputs: own king square x non-king piece x square, 40960 a side
+//   -> first layer: 256 int16 a side (the accumulator)
+//   -> both halves, side to move first, clipped to 0..127 as uint8
+//   -> 32 -> 32 -> 1, int8 weights, int32 sums, clipped to 0..127 between
+//
+// Only the first layer is large, and a move changes only a handful of its
+// inputs, so the accumulator follows the game through the BoardChanges each
+// makeMove records and is rebuilt from scratch only for a side whose king
+// moved (every one of its features depends on the king square). The small
+// dense layers run in full at every evaluation.
+//
+// Every kernel exists as AVX2, SSE2 and plain C++, chosen at run time by
+// what the CPU supports, so the build itself targets baseline x86-64 (or
+// any other CPU, where only the plain version exists). All of them compute
+// exactly the same integers.
+namespace nnue {
+
+constexpr int kFeatures  = 64 * 10 * 64;   // king square x piece x square
+constexpr int kHalfDims  = 256;            // accumulator entries a side
+constexpr int kHidden    = 32;             // both dense hidden layers
+constexpr int kOutputDiv = 16;             // network output / kOutputDiv = centipawns
+
+enum class Simd { Scalar, Sse2, Avx2 };
+
+Simd        bestSimd();          // the widest kernels this CPU runs
+Simd        simd();              // the kernels in use, bestSimd() to begin with
+void        setSimd(Simd s);     // capped at bestSimd(); for benchmarks, not while evaluating
+const char* simdName(Simd s);
+
+// A network file, memory-mapped and used in place: the weights are never
+// copied, and only the pages of the first layer that positions actually
+// touch are ever read in. The file is a 64-byte header ("CGNNUE" and the
+// layer sizes above) followed by each layer's biases and weights,
+// little-endian, every block starting on a 64-byte boundary; first-layer
+// weights are stored feature by feature, dense weights output by output.
+class Network {
+public:
+    // Replaces any loaded network; on failure the network is left empty
+    // and error() says why.
+    bool load(const std::string& path);
+
+    bool               isLoaded() const { return ftBias_ != nullptr; }
+    const std::string& path()     const { return path_; }
+    const std::string& error()    const { return error_; }
+
+    // Writes a network of random weights in the right format: for timing
+    // and for testing the plumbing, since it plays no chess to speak of.
+    static bool writeRandom(const std::string& path, std::uint64_t seed, std::string* error = nullptr);
+
+private:
+    friend struct Layers;
+
+    MappedFile          file_;
+    std::string         path_, error_;
+    const std::int16_t* ftBias_    = nullptr;   // [kHalfDims]
+    const std::int16_t* ftWeights_ = nullptr;   // [kFeatures][kHalfDims]
+    const std::int32_t* l1Bias_    = nullptr;   // [kHidden]
+    const std::int8_t*  l1Weights_ = nullptr;   // [kHidden][2 * kHalfDims]
+    const std::int32_t* l2Bias_    = nullptr;   // [kHidden]
+    const std::int8_t*  l2Weights_ = nullptr;   // [kHidden][kHidden]
+    const std::int32_t* outBias_   = nullptr;   // [1]
+    const std::int8_t*  outWeights_ = nullptr;  // [kHidden]
+};
+
+// First-layer output for both perspectives, by PieceColor.
+struct alignas(64) Accumulator {
+    std::int16_t half[2][kHalfDims];
+};
+
+// One perspective from scratch: biases plus a column per piece.
+void refresh(const Network& net, const BoardState& s, PieceColor perspective, Accumulator& acc);
+// One perspective from the previous position's accumulator; that side's
+// king must not have moved, and kingSq is where it stands.
+void update(const Network& net, const Accumulator& before, const BoardChanges& changes,
+            PieceColor perspective, int kingSq, Accumulator& after);
+// The dense layers: centipawns for the side to move.
+int  propagate(const Network& net, const Accumulator& acc, PieceColor sideToMove);
+// From scratch, as the reference for the incremental path.
+int  evaluate(const Network& net, const BoardState& s);
+
+// Accumulators by search ply. The search pushes the changes of every move
+// it makes; an accumulator is only brought up to date when its position is
+// evaluated, from the nearest ancestor that is, so interior nodes that are
+// never evaluated cost nothing but the push.
+class AccumulatorStack {
+public:
+    static constexpr int kPlies = 130;
+
+    void reset() { entries_[0].computed[0] = entries_[0].computed[1] = false; }
+    void push(int ply, const BoardChanges& changes) {
+        Entry& e = entries_[ply];
+        e.changes     = changes;
+        e.computed[0] = e.computed[1] = false;
+    }
+
+    // s is the position at ply, reached from ply 0 through the pushed moves.
+    const Accumulator& update(const Network& net, int ply, const BoardState& s);
+    int evaluate(const Network& net, int ply, const BoardState& s) {
+        return propagate(net, update(net, ply, s), s.sideToMove);
+    }
+
+    // Work done so far, one count per perspective brought up to date.
+    std::uint64_t refreshes = 0, incremental = 0;
+
+private:
+    void updateSide(const Network& net, int ply, const BoardState& s, PieceColor side);
+
+    struct Entry {
+        Accumulator  acc;
+        BoardChanges changes;   // of the move that led here
+        bool         computed[2];
+    };
+    Entry entries_[kPlies];
+};
+
+} // namespace nnue
+
+#endif // NNUE_H
@@ -0,0 +1,88 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include "chess.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Streaming PGN input. PgnReader walks a text buffer (normally a
+// MappedFile view) one game at a time and hands out views into it, so
+// nothing is copied and memory use does not grow with the input.
+
+struct PgnTag {
+    std::string_view name;
+    std::string_view value;   // between the quotes; escapes left as written
+};
+
+struct PgnGame {
+    std::vector<PgnTag> tags;            // capacity reused from game to game
+    std::string_view    movetext;        // up to and including the result, if any
+    std::size_t         offset       = 0;   // byte offset of the game in the input
+    unsigned            line         = 0;   // 1-based line of the first tag
+    unsigned            movetextLine = 0;   // 1-based line where movetext starts
+
+    // Value of the named tag, or an empty view.
+    std::string_view tag(std::string_view name) const;
+};
+
+class PgnReader {
+public:
+    // firstLine numbers the first line of text, for readers started in the
+    // middle of a file.
+    explicit PgnReader(std::string_view text, unsigned firstLine = 1)
+        : text_(text), line_(firstLine) {}
+
+    // Next game, or false at the end of the input. A game ends after its
+    // termination marker (1-0, 0-1, 1/2-1/2, *) or where the next game's
+    // tag section starts.
+    bool next(PgnGame& game);
+
+    std::size_t position() const { return pos_; }
+
+private:
+    void skipBlank();
+
+    std::string_view text_;
+    std::size_t      pos_  = 0;
+    unsigned         line_ = 1;
+};
+
+// A run of whole games cut out of a larger PGN text, so separate threads
+// can each read one with their own PgnReader.
+struct PgnChunk {
+    std::string_view text;
+    unsigned         firstLine = 1;   // line number of text's first line
+};
+
+// Cuts text into chunks of about chunkBytes. Cuts are made only in front of
+// a tag section that follows a blank line, i.e. between games as every PGN
+// exporter writes them; a game is never split.
+std::vector<PgnChunk> splitPgn(std::string_view text, std::size_t chunkBytes);
+
+struct PgnReplay {
+    int              plies = 0;    // moves played before any error
+    std::string_view result;       // termination marker; empty if missing
+    unsigned         errorLine = 0;
+    std::string      error;        // empty if the game replayed cleanly
+
+    bool ok() const { return error.empty(); }
+};
+
+// Plays the main line of a game's movetext from its FEN tag (or the
+// standard start position) into game, resolving each SAN move against the
+// legal moves. Comments, variations, NAGs and move numbers are skipped.
+// Stops at the first illegal or unreadable move, recording it and its line
+// in out. If moves is given, the main line is appended to it.
+bool replayPgn(const PgnGame& pgn, ChessGame& game, PgnReplay& out,
+               std::vector<Move>* moves = nullptr);
+
+// Appends a game as PGN text: tag pairs in the given order, a blank line,
+// numbered SAN movetext wrapped before 80 columns, and the Result tag's
+// value (or "*") as the termination marker. The moves are played from the
+// FEN tag or the standard start position; on an invalid FEN or an illegal
+// move nothing is appended and false is returned.
+bool formatPgn(const std::vector<PgnTag>& tags, const std::vector<Move>& moves, std::string& out);
+
+#endif // PGN_H
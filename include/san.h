@@ -0,0 +1,24 @@
+#ifndef SAN_H
+#define SAN_H
+
+#include "chess.h"
+#include <string>
+#include <string_view>
+
+// Standard Algebraic Notation, resolved against the legal move list of the
+// position it is played in.
+namespace san {
+
+// Accepts what real PGN files contain: "Nbd7", "exd6", "exd6 e.p.", "O-O-O"
+// (or "0-0-0"), "e8=N+", "e8N", long forms such as "Ng1-f3", and trailing
+// check, mate and !? markers. Returns Move::none() for text that is not a
+// move, matches no legal move, or matches more than one.
+Move parse(const ChessGame& game, std::string_view text);
+
+// Minimal SAN for a legal move, with "+" / "#" suffixes. The game is used
+// to play the move for the check test and is restored before returning.
+std::string format(ChessGame& game, Move move);
+
+} // namespace san
+
+#endif // SAN_H
@@ -0,0 +1,142 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "chess.h"
+#include "nnue.h"
+#include "transposition.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Scores are centipawns from the side to move's point of view. Mate scores
+// count down from kMateScore by ply so shorter mates rank higher.
+constexpr int kMateScore = 32000;
+constexpr int kInfinity  = 32001;
+constexpr int kMaxPly    = 128;
+
+constexpr bool isMateScore(int score) { return score >= kMateScore - kMaxPly || score <= -kMateScore + kMaxPly; }
+
+// Zero means "no limit" for nodes and time. Depth is always bounded by kMaxPly.
+struct SearchLimits {
+    int           depth      = kMaxPly - 1;
+    std::uint64_t nodes      = 0;
+    int           movetimeMs = 0;
+};
+
+struct SearchResult {
+    Move              bestMove = Move::none();
+    int               score    = 0;
+    int               depth    = 0;   // last fully completed iteration
+    std::uint64_t     nodes    = 0;
+    std::uint64_t     nps      = 0;
+    double            seconds  = 0;
+    std::vector<Move> pv;
+    TTStats           tt;              // this search's probes only
+    int               hashfull = 0;    // permille, 0 without a table
+};
+
+// Iterative-deepening negamax alpha-beta with quiescence search on captures.
+// Moves are ordered hash move (or previous PV move) first, then captures by
+// MVV-LVA, then killer moves, then quiets by history score. With a
+// transposition table, entries of sufficient depth cut off non-root nodes.
+//
+// With a network set, leaves are evaluated by it instead of evaluate(): the
+// searcher keeps an accumulator per ply and feeds it the changes of every
+// move it makes.
+//
+// The searcher works on its own copy of the root game, so the caller's
+// ChessGame is never touched and may keep being used (e.g. by the GUI)
+// while a search runs on another thread. stop() and nodes() are the only
+// members that are safe to call from a different thread than run().
+//
+// A stop() holds until the next prepare(), so one sent before the search
+// thread has even reached run() is not lost. A searcher that may be
+// stopped needs prepare() before every run(), called on the thread that
+// sends stop() and before the search thread is started.
+class Searcher {
+public:
+    // Called after every completed iteration with the result so far.
+    using Progress = std::function<void(const SearchResult&)>;
+
+    explicit Searcher(TranspositionTable* tt = nullptr) : tt_(tt) {}
+
+    void prepare();
+    SearchResult run(const ChessGame& root, const SearchLimits& limits,
+                     const Progress& onIteration = nullptr);
+    void stop() { stopRequested_.store(true, std::memory_order_relaxed); }
+    std::uint64_t nodes() const { return nodes_.load(std::memory_order_relaxed); }
+
+    // nullptr (the default) or an unloaded network selects evaluate(). The
+    // network is only read and may be shared; not while searching.
+    void setNetwork(const nnue::Network* net);
+
+private:
+    friend class ParallelSearcher;
+
+    // run() minus the per-search resets, which ParallelSearcher does once
+    // for all threads before any of them starts.
+    SearchResult iterate(const ChessGame& root, const SearchLimits& limits,
+                         const Progress& onIteration, int firstDepth);
+    int  search(ChessGame& game, int depth, int ply, int alpha, int beta);
+    int  quiesce(ChessGame& game, int ply, int alpha, int beta);
+    int  staticEval(const ChessGame& game, int ply);
+    void makeMove(ChessGame& game, Move m, MoveUndo& undo, int ply);
+    void orderMoves(const ChessGame& game, MoveList& moves, int ply, Move hashMove) const;
+    bool outOfBudget();
+    // Only the owning thread writes nodes_, so a plain load/store pair
+    // (no locked increment) is enough for other threads to read it.
+    void countNode() { nodes_.store(nodes_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+    TranspositionTable*        tt_;
+    TTStats                    ttStats_;
+    std::atomic<bool>          stopRequested_{false};   // by stop(), until prepare()
+    bool                       stopped_ = false;         // this run: requested or out of budget
+    std::atomic<std::uint64_t> nodes_{0};
+    SearchLimits               limits_;
+    std::int64_t               deadlineNs_ = 0;   // steady_clock; 0 = none
+    int                        rootDepth_  = 0;   // of the current iteration
+    const nnue::Network*       net_ = nullptr;
+    std::unique_ptr<nnue::AccumulatorStack> accumulators_;   // only with a network
+
+    Move killers_[kMaxPly][2];
+    int  history_[2][64][64];
+    Move pv_[kMaxPly][kMaxPly];
+    int  pvLength_[kMaxPly];
+    Move prevPv_[kMaxPly];     // last completed iteration's line, searched first
+    int  prevPvLength_ = 0;
+};
+
+// Lazy SMP: every thread runs the same iterative deepening on its own copy
+// of the root position, and the threads cooperate only through the shared
+// transposition table. Helpers start at staggered depths so they fill the
+// table ahead of the main thread; the main thread (run on the caller's
+// thread) owns the limits and the reported result, with nodes and table
+// statistics summed over all threads.
+class ParallelSearcher {
+public:
+    explicit ParallelSearcher(TranspositionTable& tt, int threads = 1);
+
+    void setThreads(int threads);   // not while a search is running
+    void setNetwork(const nnue::Network* net);   // for every thread, likewise
+    int  threads() const { return int(searchers_.size()); }
+
+    // As for Searcher: prepare() before each run() once stop() may be used.
+    void prepare();
+    SearchResult run(const ChessGame& root, const SearchLimits& limits,
+                     const Searcher::Progress& onIteration = nullptr);
+    void stop();
+
+private:
+    TranspositionTable&                    tt_;
+    const nnue::Network*                   net_ = nullptr;
+    std::vector<std::unique_ptr<Searcher>> searchers_;   // [0] is the main thread
+};
+
+// Static evaluation of the side to move in centipawns: the tapered
+// material + piece-square score (eval.h) of the terms the game keeps up to
+// date, so a leaf costs no more than the blend itself.
+int evaluate(const ChessGame& game);
+
+#endif // SEARCH_H
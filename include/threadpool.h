@@ -0,0 +1,58 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for batches of independent tasks.
+//
+// run() deals the task indices out to the workers in contiguous blocks.
+// Each worker takes from the front of its own queue; once that is empty it
+// steals from the back of another worker's, so uneven tasks (long games,
+// long matches) still keep every thread busy until the batch is done.
+class ThreadPool {
+public:
+    // 0 threads means one per hardware thread.
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return int(workers_.size()); }
+
+    // Calls task(index, worker) once for every index in [0, count) and
+    // returns when all calls have finished. worker is in [0, size()) and
+    // names the calling thread, for per-thread scratch state. One batch at
+    // a time: run() must not be called concurrently or from a task.
+    void run(std::size_t count, const std::function<void(std::size_t, int)>& task);
+
+private:
+    struct Queue {
+        std::mutex              mutex;
+        std::deque<std::size_t> items;
+    };
+
+    void workerLoop(int id);
+    bool take(int id, std::size_t& index);
+
+    std::vector<std::thread>  workers_;
+    std::unique_ptr<Queue[]>  queues_;
+
+    std::mutex                mutex_;     // guards the fields below and the wake-ups
+    std::condition_variable   wake_;
+    std::condition_variable   done_;
+    const std::function<void(std::size_t, int)>* task_ = nullptr;
+    std::atomic<std::size_t>  remaining_{0};
+    unsigned                  batch_  = 0;
+    int                       active_ = 0;   // workers between picking up a batch and going idle
+    bool                      quit_   = false;
+};
+
+#endif // THREADPOOL_H
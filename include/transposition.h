@@ -0,0 +1,122 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include "move.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Shared transposition table keyed by ChessGame::hash().
+//
+// Each entry is two 64-bit words: the packed data and key ^ data. Readers
+// and writers never lock; a reader whose two loads straddle another
+// thread's store sees a key that does not verify and treats it as a miss.
+// Buckets hold two entries: a depth-preferred slot, replaced only by an
+// equal-or-deeper search or an entry from an older search, and an
+// always-replace slot that takes everything else.
+enum class Bound : std::uint8_t { None, Upper, Lower, Exact };
+
+struct TTHit {
+    Move  move;
+    int   score;   // as stored: mate scores relative to the probing node
+    int   depth;
+    Bound bound;
+};
+
+// Per-thread probe statistics; summed by whoever owns the threads so the
+// table itself has no shared counters to contend on.
+struct TTStats {
+    std::uint64_t probes     = 0;
+    std::uint64_t hits       = 0;
+    std::uint64_t collisions = 0;   // bucket held only other positions' entries
+
+    TTStats& operator+=(const TTStats& o) {
+        probes += o.probes; hits += o.hits; collisions += o.collisions;
+        return *this;
+    }
+    double hitRate() const { return probes ? double(hits) / probes : 0; }
+};
+
+class TranspositionTable {
+public:
+    explicit TranspositionTable(std::size_t megabytes = 16) { resize(megabytes); }
+
+    // Rounded down to a power-of-two number of buckets; clears the table.
+    // Not safe while a search is using the table.
+    void resize(std::size_t megabytes);
+    void clear();
+    void newSearch() { generation_ = (generation_ + 1) & 63; }
+
+    bool probe(std::uint64_t key, TTHit& hit, TTStats& stats) const;
+    void store(std::uint64_t key, Move move, int score, int depth, Bound bound);
+
+    // Permille of sampled entries written by the current search.
+    int         hashfull() const;
+    std::size_t megabytes() const { return (mask_ + 1) * sizeof(Bucket) >> 20; }
+
+private:
+    // data: move (bits 0-15), score (16-31), depth (32-39), bound (40-41),
+    // generation (42-47). A zero data word is an empty entry.
+    struct Entry {
+        std::atomic<std::uint64_t> check{0};   // key ^ data
+        std::atomic<std::uint64_t> data{0};
+    };
+    struct alignas(32) Bucket {
+        Entry entries[2];   // [0] depth-preferred, [1] always-replace
+    };
+    static_assert(sizeof(Entry) == 16 && sizeof(Bucket) == 32, "entries must pack into 16 bytes");
+
+    static std::uint64_t pack(Move m, int score, int depth, Bound b, unsigned gen) {
+        return std::uint64_t(m.raw())
+             | std::uint64_t(std::uint16_t(std::int16_t(score))) << 16
+             | std::uint64_t(std::uint8_t(depth)) << 32
+             | std::uint64_t(b) << 40
+             | std::uint64_t(gen) << 42;
+    }
+    static int      depthOf(std::uint64_t d)      { return int((d >> 32) & 0xFF); }
+    static unsigned generationOf(std::uint64_t d) { return unsigned((d >> 42) & 63); }
+
+    Bucket& bucketFor(std::uint64_t key) const { return buckets_[key & mask_]; }
+
+    std::unique_ptr<Bucket[]> buckets_;
+    std::uint64_t             mask_       = 0;
+    unsigned                  generation_ = 0;
+};
+
+inline bool TranspositionTable::probe(std::uint64_t key, TTHit& hit, TTStats& stats) const {
+    ++stats.probes;
+    bool occupied = false;
+    for (const Entry& e : bucketFor(key).entries) {
+        std::uint64_t data  = e.data.load(std::memory_order_relaxed);
+        std::uint64_t check = e.check.load(std::memory_order_relaxed);
+        if (!data) continue;
+        if ((check ^ data) != key) { occupied = true; continue; }
+        hit.move  = Move::fromRaw(std::uint16_t(data));
+        hit.score = std::int16_t(std::uint16_t(data >> 16));
+        hit.depth = depthOf(data);
+        hit.bound = Bound((data >> 40) & 3);
+        ++stats.hits;
+        return true;
+    }
+    stats.collisions += occupied;
+    return false;
+}
+
+inline void TranspositionTable::store(std::uint64_t key, Move move, int score, int depth, Bound bound) {
+    Bucket& b = bucketFor(key);
+    Entry&  deep = b.entries[0];
+    std::uint64_t old = deep.data.load(std::memory_order_relaxed);
+    bool same = (deep.check.load(std::memory_order_relaxed) ^ old) == key;
+
+    // Keep the previous best move when re-storing a position without one.
+    if (same && move == Move::none()) move = Move::fromRaw(std::uint16_t(old));
+
+    Entry& slot = (!old || same || depth >= depthOf(old) || generationOf(old) != generation_)
+                ? deep : b.entries[1];
+    std::uint64_t data = pack(move, score, depth, bound, generation_);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
+
+#endif // TRANSPOSITION_H
@@ -0,0 +1,23 @@
+#ifndef TYPES_H
+#define TYPES_H
+
+#include <cstdint>
+
+// One byte each so BoardState keeps room for the move counters and a Piece
+// packs into four bytes.
+enum class PieceType  : std::uint8_t { None, Pawn, Rook, Knight, Bishop, Queen, King };
+enum class PieceColor : std::uint8_t { White, Black, None };
+
+struct Position {
+    int row, col;
+    constexpr Position(int r = -1, int c = -1) : row(r), col(c) {}
+    constexpr bool operator==(const Position& o) const { return row == o.row && col == o.col; }
+    constexpr bool operator!=(const Position& o) const { return !(*this == o); }
+    constexpr bool isValid() const { return row >= 0 && row < 8 && col >= 0 && col < 8; }
+};
+
+constexpr PieceColor opponent(PieceColor c) {
+    return c == PieceColor::White ? PieceColor::Black : PieceColor::White;
+}
+
+#endif // TYPES_H
@@ -0,0 +1,59 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "bitboard.h"
+#include <array>
+#include <cstdint>
+
+// 64-bit Zobrist keys, generated at compile time so every build (and every
+// tool sharing a hash-keyed file) agrees on them.
+namespace zobrist {
+
+struct Keys {
+    std::array<std::array<std::uint64_t, 64>, 12> piece{};   // [pieceIndex][square]
+    std::array<std::uint64_t, 16> castling{};                // [CastlingRight bits]
+    std::array<std::uint64_t, 8>  epFile{};
+    std::uint64_t                 blackToMove = 0;
+};
+
+constexpr std::uint64_t splitmix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr Keys makeKeys() {
+    Keys k;
+    std::uint64_t seed = 0x5EED0C4E55ULL;
+    for (auto& sq : k.piece)
+        for (auto& key : sq) key = splitmix64(seed);
+    for (auto& key : k.castling) key = splitmix64(seed);
+    for (auto& key : k.epFile)   key = splitmix64(seed);
+    k.blackToMove = splitmix64(seed);
+    return k;
+}
+
+inline constexpr Keys kKeys = makeKeys();
+
+inline std::uint64_t piece(PieceColor c, PieceType t, int sq) {
+    return kKeys.piece[pieceIndex(c, t)][sq];
+}
+inline std::uint64_t castling(std::uint8_t rights) { return kKeys.castling[rights & 15]; }
+inline std::uint64_t enPassant(int epSquare) { return epSquare >= 0 ? kKeys.epFile[epSquare & 7] : 0; }
+
+// From-scratch key: every piece, castling rights, en passant file (only set
+// when a pawn can capture after a double push) and side to move.
+inline std::uint64_t hashOf(const BoardState& s) {
+    std::uint64_t h = 0;
+    for (int i = 0; i < 12; ++i)
+        for (Bitboard b = s.pieces[i]; b; )
+            h ^= kKeys.piece[i][popLsb(b)];
+    h ^= castling(s.castling) ^ enPassant(s.epSquare);
+    if (s.sideToMove == PieceColor::Black) h ^= kKeys.blackToMove;
+    return h;
+}
+
+} // namespace zobrist
+
+#endif // ZOBRIST_H
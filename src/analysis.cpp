@@ -0,0 +1,13 @@
+#include "analysis.h"
+
+PositionAnalysis analyzePosition(const ChessGame& game) {
+    PositionAnalysis a;
+    a.hash       = game.hash();
+    a.toMove     = game.getCurrentTurn();
+    a.kingSquare = game.state().kingSquare(a.toMove);
+    a.inCheck    = game.isKingInCheck(a.toMove);
+    game.generateLegalMoves(a.moves);
+    a.checkmate  = a.inCheck && a.moves.empty();
+    a.stalemate  = !a.inCheck && a.moves.empty();
+    return a;
+}
@@ -1,464 +1,808 @@
 #include "chess.h"
+#include "attacks.h"
+#include "zobrist.h"
 #include <algorithm>
+#include <cassert>
 #include <cmath>
-#include <memory>
-#include <QDebug>
+#include <cstdio>
+#include <string>
+#include <type_traits>
 
 using namespace std;
 
-// ── local helper (piece move generators use this) ─────────────────────────────
-static Piece* at(Position p, const array<array<Piece*, 8>, 8>& b) {
-    return p.isValid() ? b[p.row][p.col] : nullptr;
-}
-
-// ── Piece subclasses ──────────────────────────────────────────────────────────
-class Pawn : public Piece {
-public:
-    Pawn(PieceColor c, Position p) : Piece(PieceType::Pawn, c, p) {}
-    unique_ptr<Piece> clone() const override { return make_unique<Pawn>(*this); }
+// ── Piece ─────────────────────────────────────────────────────────────────────
+vector<Position> Piece::getPossibleMoves(const array<array<const Piece*, 8>, 8>& board) const {
+    vector<Position> m;
+    Position from = getPosition();
+    // One step (or a whole ray for sliders) in direction (dr, dc): empty
+    // squares and an enemy piece are reachable, a piece of ours is not.
+    auto walk = [&](int dr, int dc, bool slide) {
+        for (Position np(from.row + dr, from.col + dc); np.isValid(); np = Position(np.row + dr, np.col + dc)) {
+            const Piece* p = board[np.row][np.col];
+            if (!p || p->color_ != color_) m.push_back(np);
+            if (p || !slide) break;
+        }
+    };
+    static const int kOrtho[4][2]  = { {1,0}, {-1,0}, {0,1}, {0,-1} };
+    static const int kDiag[4][2]   = { {1,1}, {1,-1}, {-1,1}, {-1,-1} };
+    static const int kKnight[8][2] = { {2,1}, {2,-1}, {-2,1}, {-2,-1}, {1,2}, {1,-2}, {-1,2}, {-1,-2} };
 
-    // Normal signature — no en passant (used for attack detection)
-    vector<Position> getPossibleMoves(const array<array<Piece*, 8>, 8>& board) const override {
-        return movesWithEP(board, Position(-1, -1));
-    }
-    // Full signature including en passant target
-    vector<Position> movesWithEP(const array<array<Piece*, 8>, 8>& board,
-                                  Position epTarget) const {
-        vector<Position> m;
+    switch (type_) {
+    case PieceType::Pawn: {
         int dir = (color_ == PieceColor::White) ? 1 : -1;
-
-        // Forward
-        Position fwd(position_.row + dir, position_.col);
-        if (fwd.isValid() && !at(fwd, board)) {
+        Position fwd(from.row + dir, from.col);
+        if (fwd.isValid() && !board[fwd.row][fwd.col]) {
             m.push_back(fwd);
-            if (!hasMoved_) {
-                Position dbl(position_.row + 2*dir, position_.col);
-                if (!at(dbl, board)) m.push_back(dbl);
-            }
+            Position dbl(from.row + 2*dir, from.col);
+            if (!hasMoved_ && dbl.isValid() && !board[dbl.row][dbl.col]) m.push_back(dbl);
         }
-        // Diagonal captures + en passant
         for (int dc : {-1, 1}) {
-            Position cap(position_.row + dir, position_.col + dc);
+            Position cap(from.row + dir, from.col + dc);
             if (!cap.isValid()) continue;
-            Piece* tgt = at(cap, board);
-            if (tgt && tgt->getColor() != color_)
-                m.push_back(cap);                 // normal capture
-            else if (cap == epTarget)
-                m.push_back(cap);                 // en passant
+            const Piece* p = board[cap.row][cap.col];
+            if (p && p->color_ != color_) m.push_back(cap);
         }
-        return m;
+        break;
     }
-};
-
-class Rook : public Piece {
-public:
-    Rook(PieceColor c, Position p) : Piece(PieceType::Rook, c, p) {}
-    unique_ptr<Piece> clone() const override { return make_unique<Rook>(*this); }
-    vector<Position> getPossibleMoves(const array<array<Piece*, 8>, 8>& board) const override {
-        vector<Position> m;
-        for (auto [dr, dc] : vector<pair<int,int>>{{1,0},{-1,0},{0,1},{0,-1}}) {
-            for (int s = 1; s < 8; ++s) {
-                Position np(position_.row+s*dr, position_.col+s*dc);
-                if (!np.isValid()) break;
-                Piece* p = at(np, board);
-                if (!p) { m.push_back(np); }
-                else { if (p->getColor() != color_) m.push_back(np); break; }
-            }
-        }
-        return m;
+    case PieceType::Knight: for (auto& d : kKnight) walk(d[0], d[1], false); break;
+    case PieceType::Bishop: for (auto& d : kDiag)   walk(d[0], d[1], true);  break;
+    case PieceType::Rook:   for (auto& d : kOrtho)  walk(d[0], d[1], true);  break;
+    case PieceType::Queen:
+        for (auto& d : kOrtho) walk(d[0], d[1], true);
+        for (auto& d : kDiag)  walk(d[0], d[1], true);
+        break;
+    case PieceType::King:   // castling is added by ChessGame::generate
+        for (auto& d : kOrtho) walk(d[0], d[1], false);
+        for (auto& d : kDiag)  walk(d[0], d[1], false);
+        break;
+    default: break;
     }
-};
-
-class Knight : public Piece {
-public:
-    Knight(PieceColor c, Position p) : Piece(PieceType::Knight, c, p) {}
-    unique_ptr<Piece> clone() const override { return make_unique<Knight>(*this); }
-    vector<Position> getPossibleMoves(const array<array<Piece*, 8>, 8>& board) const override {
-        vector<Position> m;
-        for (auto [dr,dc] : vector<pair<int,int>>{{2,1},{2,-1},{-2,1},{-2,-1},{1,2},{1,-2},{-1,2},{-1,-2}}) {
-            Position np(position_.row+dr, position_.col+dc);
-            if (np.isValid()) {
-                Piece* p = at(np, board);
-                if (!p || p->getColor() != color_) m.push_back(np);
-            }
-        }
-        return m;
+    return m;
+}
+
+// ── ChessGame implementation ──────────────────────────────────────────────────
+
+// Castling rights that survive a move from or to each square: touching a
+// king or rook home square (including capturing the rook) drops its rights.
+static const array<uint8_t, 64> kCastlingMask = [] {
+    array<uint8_t, 64> m;
+    m.fill(AllCastling);
+    m[0]  = AllCastling & ~WhiteQueenside;
+    m[7]  = AllCastling & ~WhiteKingside;
+    m[4]  = AllCastling & ~(WhiteKingside | WhiteQueenside);
+    m[56] = AllCastling & ~BlackQueenside;
+    m[63] = AllCastling & ~BlackKingside;
+    m[60] = AllCastling & ~(BlackKingside | BlackQueenside);
+    return m;
+}();
+
+// Castling right belonging to the rook on each corner square.
+static const array<uint8_t, 64> kCastlingRookRight = [] {
+    array<uint8_t, 64> r{};
+    r[0]  = WhiteQueenside;
+    r[7]  = WhiteKingside;
+    r[56] = BlackQueenside;
+    r[63] = BlackKingside;
+    return r;
+}();
+
+// A double push only leaves an en passant square when a pawn of the side
+// to move stands next to the arrival square. Otherwise the position is the
+// same as one without it, and must compare and hash the same for
+// repetitions.
+static bool epCapturable(const BoardState& s, int epSq, PieceColor capturer) {
+    return attacks::pawn(opponent(capturer), epSq) & s.of(capturer, PieceType::Pawn);
+}
+
+static_assert(is_trivially_copyable_v<ChessGame>, "ChessGame copies must stay a memcpy");
+static_assert(sizeof(Piece) == 4, "pool slots are meant to pack four bytes each");
+
+ChessGame::ChessGame() {
+    initializeBoard();
+}
+
+void ChessGame::initializeBoard() {
+    static const PieceType kBackRank[8] = {
+        PieceType::Rook, PieceType::Knight, PieceType::Bishop, PieceType::Queen,
+        PieceType::King, PieceType::Bishop, PieceType::Knight, PieceType::Rook,
+    };
+    state_ = BoardState();
+    for (int c = 0; c < 8; ++c) {
+        state_.put(PieceColor::White, kBackRank[c], c);
+        state_.put(PieceColor::White, PieceType::Pawn, 8 + c);
+        state_.put(PieceColor::Black, PieceType::Pawn, 48 + c);
+        state_.put(PieceColor::Black, kBackRank[c], 56 + c);
     }
-};
-
-class Bishop : public Piece {
-public:
-    Bishop(PieceColor c, Position p) : Piece(PieceType::Bishop, c, p) {}
-    unique_ptr<Piece> clone() const override { return make_unique<Bishop>(*this); }
-    vector<Position> getPossibleMoves(const array<array<Piece*, 8>, 8>& board) const override {
-        vector<Position> m;
-        for (auto [dr,dc] : vector<pair<int,int>>{{1,1},{1,-1},{-1,1},{-1,-1}}) {
-            for (int s = 1; s < 8; ++s) {
-                Position np(position_.row+s*dr, position_.col+s*dc);
-                if (!np.isValid()) break;
-                Piece* p = at(np, board);
-                if (!p) { m.push_back(np); }
-                else { if (p->getColor() != color_) m.push_back(np); break; }
+    state_.castling = AllCastling;
+    hash_  = zobrist::hashOf(state_);
+    eval_  = eval::termsOf(state_);
+    plies_ = 0;
+    rebuildPieces();
+}
+
+// Refills the pool from state_, one slot per piece in square order.
+// hasMoved() is only informational now; derive something sensible from
+// pawn ranks and the castling rights.
+void ChessGame::rebuildPieces() {
+    pieces_ = {};
+    slotAt_.fill(MoveUndo::kNoPiece);
+    used_ = 0;
+    for (Bitboard occ = state_.occupied; occ; ) {
+        int sq = popLsb(occ);
+        PieceColor c = (state_.of(PieceColor::White) & bit(sq)) ? PieceColor::White : PieceColor::Black;
+        PieceType  t = state_.typeAt(sq);
+        Piece& piece = pieces_[used_];
+        piece = Piece(t, c, positionOf(sq));
+        int homeRow = (c == PieceColor::White) ? 0 : 7;
+        uint8_t kingRights = (c == PieceColor::White) ? (WhiteKingside | WhiteQueenside)
+                                                      : (BlackKingside | BlackQueenside);
+        if (t == PieceType::Pawn)
+            piece.hasMoved_ = (sq >> 3) != (c == PieceColor::White ? 1 : 6);
+        else if (t == PieceType::King)
+            piece.hasMoved_ = !(state_.castling & kingRights);
+        else if (t == PieceType::Rook)
+            piece.hasMoved_ = !(state_.castling & kCastlingRookRight[sq]);
+        else
+            piece.hasMoved_ = (sq >> 3) != homeRow;
+        slotAt_[sq] = used_++;
+    }
+}
+
+// Splits off the next space-separated field; empty once fen is exhausted.
+static string_view nextField(string_view& fen) {
+    size_t begin = fen.find_first_not_of(' ');
+    if (begin == string_view::npos) { fen = {}; return {}; }
+    fen.remove_prefix(begin);
+    size_t end = min(fen.find(' '), fen.size());
+    string_view field = fen.substr(0, end);
+    fen.remove_prefix(end);
+    return field;
+}
+
+// Non-negative decimal that fits in 16 bits.
+static bool parseCounter(string_view field, uint16_t& out) {
+    if (field.empty() || field.size() > 5) return false;
+    unsigned value = 0;
+    for (char ch : field) {
+        if (ch < '0' || ch > '9') return false;
+        value = value * 10 + unsigned(ch - '0');
+    }
+    if (value > 0xFFFF) return false;
+    out = uint16_t(value);
+    return true;
+}
+
+bool ChessGame::parseFEN(string_view fen, BoardState& out) {
+    string_view placement = nextField(fen), side = nextField(fen);
+    string_view castling  = nextField(fen), ep   = nextField(fen);
+    string_view halfmove  = nextField(fen), fullmove = nextField(fen);
+    if (placement.empty() || side.empty() || !nextField(fen).empty()) return false;
+
+    BoardState next;
+    int row = 7, col = 0;
+    for (char ch : placement) {
+        if (ch == '/') {
+            if (col != 8 || row == 0) return false;
+            --row; col = 0;
+        } else if (ch >= '1' && ch <= '8') {
+            col += ch - '0';
+            if (col > 8) return false;
+        } else {
+            PieceType t;
+            switch (ch | 0x20) {   // lower case
+            case 'p': t = PieceType::Pawn;   break;
+            case 'r': t = PieceType::Rook;   break;
+            case 'n': t = PieceType::Knight; break;
+            case 'b': t = PieceType::Bishop; break;
+            case 'q': t = PieceType::Queen;  break;
+            case 'k': t = PieceType::King;   break;
+            default:  return false;
             }
+            if (col > 7) return false;
+            PieceColor c = (ch & 0x20) ? PieceColor::Black : PieceColor::White;
+            next.put(c, t, row * 8 + col);
+            ++col;
         }
-        return m;
     }
-};
-
-class Queen : public Piece {
-public:
-    Queen(PieceColor c, Position p) : Piece(PieceType::Queen, c, p) {}
-    unique_ptr<Piece> clone() const override { return make_unique<Queen>(*this); }
-    vector<Position> getPossibleMoves(const array<array<Piece*, 8>, 8>& board) const override {
-        vector<Position> m;
-        for (auto [dr,dc] : vector<pair<int,int>>{{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}}) {
-            for (int s = 1; s < 8; ++s) {
-                Position np(position_.row+s*dr, position_.col+s*dc);
-                if (!np.isValid()) break;
-                Piece* p = at(np, board);
-                if (!p) { m.push_back(np); }
-                else { if (p->getColor() != color_) m.push_back(np); break; }
+    if (row != 0 || col != 8) return false;
+    if (popCount(next.of(PieceColor::White, PieceType::King)) != 1 ||
+        popCount(next.of(PieceColor::Black, PieceType::King)) != 1) return false;
+    // The piece pool is sized for a real game: 16 men a side at most.
+    if (popCount(next.of(PieceColor::White)) > 16 || popCount(next.of(PieceColor::Black)) > 16)
+        return false;
+    if ((next.of(PieceColor::White, PieceType::Pawn) | next.of(PieceColor::Black, PieceType::Pawn)) &
+        (kRank1 | kRank8))
+        return false;
+
+    if      (side == "w") next.sideToMove = PieceColor::White;
+    else if (side == "b") next.sideToMove = PieceColor::Black;
+    else return false;
+
+    if (castling.empty()) castling = "-";
+    if (castling != "-")
+        for (char ch : castling) {
+            switch (ch) {
+            case 'K': next.castling |= WhiteKingside;  break;
+            case 'Q': next.castling |= WhiteQueenside; break;
+            case 'k': next.castling |= BlackKingside;  break;
+            case 'q': next.castling |= BlackQueenside; break;
+            default:  return false;
             }
         }
-        return m;
+    // A right whose king or rook is not on its home square can never be
+    // used; dropping it keeps one key per position for the table and for
+    // repetitions.
+    for (int corner : { 0, 7, 56, 63 }) {
+        PieceColor c    = corner < 8 ? PieceColor::White : PieceColor::Black;
+        int        king = corner < 8 ? 4 : 60;
+        if (!(next.of(c, PieceType::Rook) & bit(corner)) || !(next.of(c, PieceType::King) & bit(king)))
+            next.castling &= ~kCastlingRookRight[corner];
     }
-};
-
-class King : public Piece {
-public:
-    King(PieceColor c, Position p) : Piece(PieceType::King, c, p) {}
-    unique_ptr<Piece> clone() const override { return make_unique<King>(*this); }
-    // NOTE: castling squares intentionally NOT included here.
-    // They require attack-detection (ChessGame context) and are added by getValidMoves.
-    vector<Position> getPossibleMoves(const array<array<Piece*, 8>, 8>& board) const override {
-        vector<Position> m;
-        for (int dr = -1; dr <= 1; ++dr)
-            for (int dc = -1; dc <= 1; ++dc) {
-                if (!dr && !dc) continue;
-                Position np(position_.row+dr, position_.col+dc);
-                if (np.isValid()) {
-                    Piece* p = at(np, board);
-                    if (!p || p->getColor() != color_) m.push_back(np);
-                }
-            }
-        return m;
+
+    if (!ep.empty() && ep != "-") {
+        // Only the rank behind a pawn the side to move could capture.
+        char rank = next.sideToMove == PieceColor::White ? '6' : '3';
+        if (ep.size() != 2 || ep[0] < 'a' || ep[0] > 'h' || ep[1] != rank) return false;
+        int sq = (ep[1] - '1') * 8 + (ep[0] - 'a');
+        if (epCapturable(next, sq, next.sideToMove)) next.epSquare = int8_t(sq);
     }
-};
 
-// ── ChessGame implementation ──────────────────────────────────────────────────
+    if (!halfmove.empty() && !parseCounter(halfmove, next.halfmoveClock)) return false;
+    if (!fullmove.empty() && (!parseCounter(fullmove, next.fullmoveNumber) ||
+                              next.fullmoveNumber == 0)) return false;
 
-ChessGame::ChessGame()
-    : currentTurn_(PieceColor::White),
-      whiteKingPos_(-1,-1), blackKingPos_(-1,-1),
-      enPassantTarget_(-1,-1) {
-    for (auto& row : board_) row.fill(nullptr);
-    initializeBoard();
+    out = next;
+    return true;
 }
 
-// FIX: copy constructor always sets threatCacheValid_=false so the copy
-//      recomputes on its first isKingInCheck call rather than using stale data.
-ChessGame::ChessGame(const ChessGame& other)
-    : currentTurn_(other.currentTurn_),
-      whiteKingPos_(other.whiteKingPos_),
-      blackKingPos_(other.blackKingPos_),
-      enPassantTarget_(other.enPassantTarget_) {
-    for (auto& row : board_) row.fill(nullptr);
-
-    for (const auto& p : other.pieces_)
-        pieces_.push_back(p->clone());
-
-    // Rebuild board_ by matching cloned pieces to original board positions.
-    // Match on position+type+color to avoid ambiguity between promoted pieces.
-    for (int r = 0; r < 8; ++r) {
-        for (int c = 0; c < 8; ++c) {
-            Piece* orig = other.board_[r][c];
-            if (!orig) continue;
-            for (auto& cloned : pieces_) {
-                if (cloned->getPosition() == Position(r, c) &&
-                    cloned->getType()     == orig->getType() &&
-                    cloned->getColor()    == orig->getColor()) {
-                    board_[r][c] = cloned.get();
-                    break;
-                }
-            }
+// Sets up the position and rebuilds the Piece view from it.
+bool ChessGame::fromFEN(string_view fen) {
+    BoardState next;
+    if (!parseFEN(fen, next)) return false;
+
+    state_ = next;
+    hash_  = zobrist::hashOf(state_);
+    eval_  = eval::termsOf(state_);
+    plies_ = 0;
+    rebuildPieces();
+    return true;
+}
+
+string ChessGame::toFEN() const {
+    static const char kLetters[] = "PRNBQKprnbqk";   // by pieceIndex()
+    char squares[64] = {};
+    for (int i = 0; i < 12; ++i)
+        for (Bitboard bb = state_.pieces[i]; bb; ) squares[popLsb(bb)] = kLetters[i];
+
+    char buf[96];
+    char* p = buf;
+    for (int row = 7; row >= 0; --row) {
+        int empty = 0;
+        for (int col = 0; col < 8; ++col) {
+            char ch = squares[row * 8 + col];
+            if (!ch) { ++empty; continue; }
+            if (empty) { *p++ = char('0' + empty); empty = 0; }
+            *p++ = ch;
         }
+        if (empty) *p++ = char('0' + empty);
+        if (row) *p++ = '/';
     }
+
+    *p++ = ' ';
+    *p++ = state_.sideToMove == PieceColor::White ? 'w' : 'b';
+    *p++ = ' ';
+    if (!state_.castling) *p++ = '-';
+    if (state_.castling & WhiteKingside)  *p++ = 'K';
+    if (state_.castling & WhiteQueenside) *p++ = 'Q';
+    if (state_.castling & BlackKingside)  *p++ = 'k';
+    if (state_.castling & BlackQueenside) *p++ = 'q';
+    *p++ = ' ';
+    if (state_.epSquare < 0) {
+        *p++ = '-';
+    } else {
+        *p++ = char('a' + (state_.epSquare & 7));
+        *p++ = char('1' + (state_.epSquare >> 3));
+    }
+    p += snprintf(p, buf + sizeof buf - p, " %u %u",
+                  unsigned(state_.halfmoveClock), unsigned(state_.fullmoveNumber));
+    return string(buf, p);
 }
 
-ChessGame& ChessGame::operator=(const ChessGame& other) {
-    if (this == &other) return *this;
-    pieces_.clear();
-    for (auto& row : board_) row.fill(nullptr);
-    currentTurn_     = other.currentTurn_;
-    whiteKingPos_    = other.whiteKingPos_;
-    blackKingPos_    = other.blackKingPos_;
-    enPassantTarget_ = other.enPassantTarget_;
-    for (const auto& p : other.pieces_) pieces_.push_back(p->clone());
-    for (int r = 0; r < 8; ++r) {
-        for (int c = 0; c < 8; ++c) {
-            Piece* orig = other.board_[r][c];
-            if (!orig) continue;
-            for (auto& cloned : pieces_) {
-                if (cloned->getPosition() == Position(r, c) &&
-                    cloned->getType()     == orig->getType() &&
-                    cloned->getColor()    == orig->getColor()) {
-                    board_[r][c] = cloned.get();
-                    break;
-                }
-            }
-        }
+int ChessGame::repetitions(int limit) const {
+    // Only the same side to move can repeat, and the first candidate is
+    // four plies back: two moves each are needed to return to a position.
+    // Play can go on past the fifty-move rule (the GUI, or a FEN with a
+    // large clock), but the ring only holds the last kHistorySize keys;
+    // looking further back would wrap onto newer ones.
+    int back  = min({ int(state_.halfmoveClock), plies_, kHistorySize });
+    int count = 0;
+    for (int i = 4; i <= back; i += 2)
+        if (history_[(plies_ - i) & (kHistorySize - 1)] == hash_ && ++count >= limit) break;
+    return count;
+}
+
+// Neither side can ever mate: bare kings, a single minor piece, or only
+// bishops that all stand on squares of one colour.
+bool ChessGame::isInsufficientMaterial() const {
+    const BoardState& s = state_;
+    Bitboard heavy = 0;
+    for (PieceColor c : { PieceColor::White, PieceColor::Black })
+        heavy |= s.of(c, PieceType::Pawn) | s.of(c, PieceType::Rook) | s.of(c, PieceType::Queen);
+    if (heavy) return false;
+
+    Bitboard knights = s.of(PieceColor::White, PieceType::Knight) | s.of(PieceColor::Black, PieceType::Knight);
+    Bitboard bishops = s.of(PieceColor::White, PieceType::Bishop) | s.of(PieceColor::Black, PieceType::Bishop);
+    if (!knights) {
+        constexpr Bitboard kDark = 0xAA55AA55AA55AA55ULL;   // a1 is dark
+        return !(bishops & kDark) || !(bishops & ~kDark);
     }
-    return *this;
+    return !bishops && popCount(knights) == 1;
 }
 
-void ChessGame::initializeBoard() {
-    pieces_.clear();
-    for (auto& row : board_) row.fill(nullptr);
-    enPassantTarget_ = Position(-1, -1);
-
-    auto place = [&](unique_ptr<Piece> p) {
-        Position pos = p->getPosition();
-        board_[pos.row][pos.col] = p.get();
-        pieces_.push_back(move(p));
-    };
-    for (int c = 0; c < 8; ++c) {
-        place(make_unique<Pawn>(PieceColor::White, Position(1, c)));
-        place(make_unique<Pawn>(PieceColor::Black, Position(6, c)));
+ChessGame::DrawReason ChessGame::drawReason() const {
+    if (isInsufficientMaterial()) return DrawReason::InsufficientMaterial;
+    if (isFiftyMoveDraw())        return DrawReason::FiftyMoves;
+    if (repetitions() >= 2)       return DrawReason::Repetition;
+    return DrawReason::None;
+}
+
+const Piece* ChessGame::getPieceAt(Position pos) const {
+    if (!pos.isValid()) return nullptr;
+    uint8_t slot = slotAt_[squareOf(pos)];
+    return slot == MoveUndo::kNoPiece ? nullptr : &pieces_[slot];
+}
+
+// Pseudo-legal destinations for the piece on sq (castling excluded): pawn
+// pushes by shifting, everything else from the attack tables.
+Bitboard ChessGame::pseudoTargets(int sq) const {
+    const Piece& piece = pieces_[slotAt_[sq]];
+    PieceColor us   = piece.getColor();
+    Bitboard   occ  = state_.occupied;
+    Bitboard   own  = state_.of(us);
+
+    switch (piece.getType()) {
+    case PieceType::Pawn: {
+        Bitboard from = bit(sq), push, dbl;
+        if (us == PieceColor::White) {
+            push = (from << 8) & ~occ;
+            dbl  = ((push & (kRank2 << 8)) << 8) & ~occ;
+        } else {
+            push = (from >> 8) & ~occ;
+            dbl  = ((push & (kRank7 >> 8)) >> 8) & ~occ;
+        }
+        // En passant only belongs to the side to move.
+        Bitboard targets = state_.of(opponent(us));
+        if (state_.epSquare >= 0 && us == state_.sideToMove)
+            targets |= bit(state_.epSquare);
+        return push | dbl | (attacks::pawn(us, sq) & targets);
     }
-    place(make_unique<Rook>  (PieceColor::White, Position(0,0)));
-    place(make_unique<Rook>  (PieceColor::White, Position(0,7)));
-    place(make_unique<Rook>  (PieceColor::Black, Position(7,0)));
-    place(make_unique<Rook>  (PieceColor::Black, Position(7,7)));
-    place(make_unique<Knight>(PieceColor::White, Position(0,1)));
-    place(make_unique<Knight>(PieceColor::White, Position(0,6)));
-    place(make_unique<Knight>(PieceColor::Black, Position(7,1)));
-    place(make_unique<Knight>(PieceColor::Black, Position(7,6)));
-    place(make_unique<Bishop>(PieceColor::White, Position(0,2)));
-    place(make_unique<Bishop>(PieceColor::White, Position(0,5)));
-    place(make_unique<Bishop>(PieceColor::Black, Position(7,2)));
-    place(make_unique<Bishop>(PieceColor::Black, Position(7,5)));
-    place(make_unique<Queen> (PieceColor::White, Position(0,3)));
-    place(make_unique<Queen> (PieceColor::Black, Position(7,3)));
-    place(make_unique<King>  (PieceColor::White, Position(0,4)));
-    place(make_unique<King>  (PieceColor::Black, Position(7,4)));
-    whiteKingPos_ = Position(0,4);
-    blackKingPos_ = Position(7,4);
-}
-
-Piece* ChessGame::getPieceAt(Position pos) const {
-    return pos.isValid() ? board_[pos.row][pos.col] : nullptr;
-}
-
-// Returns all raw moves for a piece, including en passant for pawns.
-vector<Position> ChessGame::getRawMoves(const Piece* piece) const {
-    if (piece->getType() == PieceType::Pawn)
-        return static_cast<const Pawn*>(piece)->movesWithEP(board_, enPassantTarget_);
-    return piece->getPossibleMoves(board_);
-}
-
-// FIX: check if a square is attacked by any piece of the given color.
-// Used for castling legality (king cannot pass through or land on an attacked square).
-bool ChessGame::isSquareAttackedBy(Position sq, PieceColor attacker) const {
-    for (const auto& p : pieces_) {
-        if (p->getColor() != attacker) continue;
-        // Use base getPossibleMoves (no ep needed for attack detection)
-        auto moves = p->getPossibleMoves(board_);
-        if (find(moves.begin(), moves.end(), sq) != moves.end())
-            return true;
+    case PieceType::Knight: return attacks::knight(sq) & ~own;
+    case PieceType::Bishop: return attacks::bishop(sq, occ) & ~own;
+    case PieceType::Rook:   return attacks::rook(sq, occ) & ~own;
+    case PieceType::Queen:  return attacks::queen(sq, occ) & ~own;
+    case PieceType::King:   return attacks::king(sq) & ~own;
+    default:                return 0;
     }
-    return false;
+}
+
+// Castling destinations for us's king on kingSq: the right must still be
+// held, the squares between king and rook empty, and the king may not start
+// in, pass through or land on an attacked square.
+Bitboard ChessGame::castlingTargets(int kingSq, PieceColor us) const {
+    PieceColor opp = opponent(us);
+    int base = (us == PieceColor::White) ? 0 : 56;
+    if (kingSq != base + 4) return 0;
+
+    uint8_t ks = (us == PieceColor::White) ? WhiteKingside  : BlackKingside;
+    uint8_t qs = (us == PieceColor::White) ? WhiteQueenside : BlackQueenside;
+    if (!(state_.castling & (ks | qs))) return 0;
+
+    if (attacks::isAttacked(state_, kingSq, opp)) return 0;
+
+    Bitboard occ   = state_.occupied;
+    Bitboard rooks = state_.of(us, PieceType::Rook);
+    Bitboard targets = 0;
+    if ((state_.castling & ks) && (rooks & bit(base + 7)) &&
+        !(occ & (bit(base + 5) | bit(base + 6))) &&
+        !attacks::isAttacked(state_, base + 5, opp) &&
+        !attacks::isAttacked(state_, base + 6, opp))
+        targets |= bit(base + 6);
+    if ((state_.castling & qs) && (rooks & bit(base)) &&
+        !(occ & (bit(base + 1) | bit(base + 2) | bit(base + 3))) &&
+        !attacks::isAttacked(state_, base + 3, opp) &&
+        !attacks::isAttacked(state_, base + 2, opp))
+        targets |= bit(base + 2);
+    return targets;
+}
+
+// Used for check detection and castling legality (king cannot pass through
+// or land on an attacked square). Reverse lookup from the target square with
+// early exit — see attacks::isAttacked.
+bool ChessGame::isSquareAttackedBy(Position sq, PieceColor attacker) const {
+    return attacks::isAttacked(state_, squareOf(sq), attacker);
 }
 
 // FIX: isKingInCheck always recomputes from scratch (no cache).
 //      The old cache was copied into temp games as "valid" and caused wrong results.
 bool ChessGame::isKingInCheck(PieceColor color) const {
-    Position kingPos = (color == PieceColor::White) ? whiteKingPos_ : blackKingPos_;
-    if (!kingPos.isValid()) return false;
-    PieceColor opp = (color == PieceColor::White) ? PieceColor::Black : PieceColor::White;
-    return isSquareAttackedBy(kingPos, opp);
+    int kingSq = state_.kingSquare(color);
+    if (kingSq < 0) return false;
+    return isSquareAttackedBy(positionOf(kingSq), opponent(color));
 }
 
-// Returns all fully legal moves for the piece at pos.
+// Returns all fully legal moves for the piece at pos (one entry per
+// destination; promotions are reported once).
 vector<Position> ChessGame::getValidMoves(Position pos) const {
     vector<Position> result;
-    Piece* piece = getPieceAt(pos);
-    if (!piece || piece->getColor() != currentTurn_) return result;
-
-    // Raw moves (includes en passant for pawns)
-    for (const auto& to : getRawMoves(piece)) {
-        if (isMoveLegal(pos, to))
-            result.push_back(to);
-    }
-
-    // FIX: Castling — only added here where we can call isSquareAttackedBy safely.
-    if (piece->getType() == PieceType::King && !piece->hasMoved() && !isKingInCheck(piece->getColor())) {
-        int row = pos.row;
-        PieceColor opp = (piece->getColor() == PieceColor::White) ? PieceColor::Black : PieceColor::White;
-
-        // Kingside: squares between king and rook at col 7 must be empty,
-        //           king cannot pass through (col+1) or land on (col+2) attacked square.
-        {
-            bool clear = true;
-            for (int c = pos.col+1; c < 7; ++c)
-                if (board_[row][c]) { clear = false; break; }
-            if (clear) {
-                Piece* rook = getPieceAt(Position(row, 7));
-                if (rook && rook->getType() == PieceType::Rook &&
-                    rook->getColor() == piece->getColor() && !rook->hasMoved() &&
-                    !isSquareAttackedBy(Position(row, pos.col+1), opp) &&
-                    !isSquareAttackedBy(Position(row, pos.col+2), opp)) {
-                    result.push_back(Position(row, pos.col+2));
-                }
-            }
-        }
-        // Queenside: squares between king and rook at col 0 must be empty,
-        //            king cannot pass through (col-1) or land on (col-2) attacked square.
-        {
-            bool clear = true;
-            for (int c = pos.col-1; c > 0; --c)
-                if (board_[row][c]) { clear = false; break; }
-            if (clear) {
-                Piece* rook = getPieceAt(Position(row, 0));
-                if (rook && rook->getType() == PieceType::Rook &&
-                    rook->getColor() == piece->getColor() && !rook->hasMoved() &&
-                    !isSquareAttackedBy(Position(row, pos.col-1), opp) &&
-                    !isSquareAttackedBy(Position(row, pos.col-2), opp)) {
-                    result.push_back(Position(row, pos.col-2));
-                }
-            }
-        }
-    }
-
+    const Piece* piece = getPieceAt(pos);
+    if (!piece || piece->getColor() != state_.sideToMove) return result;
+
+    MoveList moves;
+    generate(moves, GenKind::All, state_.sideToMove, bit(squareOf(pos)));
+    for (Move m : moves)
+        if (!m.isPromotion() || m.promotion() == PieceType::Queen)
+            result.push_back(m.toPos());
     return result;
 }
 
-// FIX: isMoveLegal — simulate the move on a fresh copy.
-//      The copy always has a clean state (no stale cache).
-//      En passant simulation correctly removes the captured pawn.
-bool ChessGame::isMoveLegal(Position from, Position to) const {
-    ChessGame tmp(*this);  // copy has no cache (threatCacheValid_ never stored)
-
-    Piece* piece = tmp.getPieceAt(from);
-    if (!piece) return false;
+void ChessGame::generateLegalMoves(MoveList& list) const { generate(list, GenKind::All, state_.sideToMove); }
+void ChessGame::generateCaptures(MoveList& list) const   { generate(list, GenKind::Captures, state_.sideToMove); }
+void ChessGame::generateQuiets(MoveList& list) const     { generate(list, GenKind::Quiets, state_.sideToMove); }
+
+// Appends us's legal moves whose origin is in fromMask, encoded with their
+// capture / castle / en passant / promotion flags. Legality comes from masks
+// rather than make/unmake probes:
+//   - the king may step to any square the enemy attacks with the king itself
+//     removed from the board (so it cannot hide behind itself on a ray);
+//   - in double check only the king moves;
+//   - in single check every other move must capture the checker or land
+//     between it and the king (checkMask);
+//   - a piece pinned to the king stays on the king-pinner line;
+//   - en passant removes two pawns from one rank, so it is verified against
+//     the resulting occupancy directly.
+// firstOnly stops after the first move found (hasLegalMoves).
+void ChessGame::generate(MoveList& list, GenKind kind, PieceColor us,
+                         Bitboard fromMask, bool firstOnly) const {
+    PieceColor them    = opponent(us);
+    Bitboard   own     = state_.of(us);
+    Bitboard   enemies = state_.of(them);
+    Bitboard   occ     = state_.occupied;
+    int        ksq     = state_.kingSquare(us);
+    if (ksq < 0) return;
+
+    Bitboard targetMask = kind == GenKind::Captures ? enemies
+                        : kind == GenKind::Quiets   ? ~occ
+                                                    : ~own;
+    auto add = [&](int from, int to, int flags) {
+        list.add(Move(from, to, flags));
+        return firstOnly;
+    };
 
-    tmp.board_[from.row][from.col] = nullptr;
+    Bitboard checkers = attacks::attackersTo(state_, ksq, them, occ);
 
-    // Update king tracking in simulation
-    if (piece->getType() == PieceType::King) {
-        if (piece->getColor() == PieceColor::White) tmp.whiteKingPos_ = to;
-        else                                         tmp.blackKingPos_ = to;
+    if (fromMask & bit(ksq)) {
+        Bitboard targets = attacks::king(ksq) & targetMask
+                         & ~state_.attacksBy(them, occ ^ bit(ksq));
+        while (targets) {
+            int to = popLsb(targets);
+            if (add(ksq, to, (enemies & bit(to)) ? Capture : Quiet)) return;
+        }
+        if (!checkers && kind != GenKind::Captures)
+            for (Bitboard castles = castlingTargets(ksq, us); castles; ) {
+                int to = popLsb(castles);
+                if (add(ksq, to, to > ksq ? KingCastle : QueenCastle)) return;
+            }
     }
-
-    // FIX: handle en passant in the simulation so the captured pawn is removed
-    bool isEP = (piece->getType() == PieceType::Pawn &&
-                 from.col != to.col && !tmp.getPieceAt(to));
-    if (isEP) {
-        tmp.removePieceAt(Position(from.row, to.col));   // remove captured pawn
-    } else {
-        tmp.removePieceAt(to);                           // normal capture
+    if (popCount(checkers) > 1) return;
+
+    Bitboard checkMask = checkers ? checkers | attacks::between(ksq, lsb(checkers))
+                                  : ~Bitboard(0);
+
+    // Enemy sliders seeing the king through exactly one of our pieces pin it.
+    Bitboard queens  = state_.of(them, PieceType::Queen);
+    Bitboard snipers = (attacks::rook(ksq, enemies)   & (state_.of(them, PieceType::Rook)   | queens))
+                     | (attacks::bishop(ksq, enemies) & (state_.of(them, PieceType::Bishop) | queens));
+    Bitboard pinned = 0;
+    while (snipers) {
+        Bitboard blockers = attacks::between(ksq, popLsb(snipers)) & occ;
+        if (popCount(blockers) == 1 && (blockers & own)) pinned |= blockers;
     }
 
-    piece->setPosition(to);
-    tmp.board_[to.row][to.col] = piece;
+    Bitboard ep = (state_.epSquare >= 0 && us == state_.sideToMove) ? bit(state_.epSquare) : 0;
+
+    for (Bitboard pieces = own & fromMask & ~bit(ksq); pieces; ) {
+        int from = popLsb(pieces);
+        PieceType type = pieces_[slotAt_[from]].getType();
+
+        Bitboard targets = pseudoTargets(from) & targetMask & checkMask;
+        if (type == PieceType::Pawn) targets &= ~ep;
+        if (pinned & bit(from)) targets &= attacks::line(ksq, from);
+
+        while (targets) {
+            int to = popLsb(targets);
+            int capture = (enemies & bit(to)) ? Capture : Quiet;
+            if (type != PieceType::Pawn) {
+                if (add(from, to, capture)) return;
+            } else if (bit(to) & (kRank1 | kRank8)) {
+                for (int promo : { PromoQueen, PromoKnight, PromoRook, PromoBishop })
+                    list.add(Move(from, to, promo | capture));
+                if (firstOnly) return;
+            } else {
+                if (add(from, to, abs(to - from) == 16 ? DoublePush : capture)) return;
+            }
+        }
 
-    return !tmp.isKingInCheck(currentTurn_);
+        if (type == PieceType::Pawn && kind != GenKind::Quiets && (attacks::pawn(us, from) & ep)) {
+            int to  = state_.epSquare;
+            int cap = (us == PieceColor::White) ? to - 8 : to + 8;
+            Bitboard after = (occ ^ bit(from) ^ bit(cap)) | bit(to);
+            Bitboard diag  = state_.of(them, PieceType::Bishop) | queens;
+            Bitboard ortho = state_.of(them, PieceType::Rook)   | queens;
+            bool exposed = (attacks::rook(ksq, after) & ortho)
+                        || (attacks::bishop(ksq, after) & diag)
+                        || (attacks::knight(ksq) & state_.of(them, PieceType::Knight))
+                        || (attacks::pawn(us, ksq) & state_.of(them, PieceType::Pawn) & ~bit(cap));
+            if (!exposed && add(from, to, EnPassant)) return;
+        }
+    }
 }
 
 bool ChessGame::movePiece(Position from, Position to) {
-    Piece* piece = getPieceAt(from);
-    if (!piece || piece->getColor() != currentTurn_) return false;
-
-    // Use getValidMoves which covers castling + en passant
-    auto valid = getValidMoves(from);
-    if (find(valid.begin(), valid.end(), to) == valid.end()) return false;
-
-    // FIX: Save piece pointer BEFORE clearing the board square.
-    //      handleCastling and handleEnPassant used to call getPieceAt(from)
-    //      after board_[from] was already set to nullptr → null deref crash.
-    Piece* movingPiece = piece;
-    board_[from.row][from.col] = nullptr;
-
-    // Track king position
-    if (movingPiece->getType() == PieceType::King) {
-        if (movingPiece->getColor() == PieceColor::White) whiteKingPos_ = to;
-        else                                               blackKingPos_ = to;
+    const Piece* piece = getPieceAt(from);
+    if (!piece || piece->getColor() != state_.sideToMove) return false;
+
+    // Only legal moves (castling and en passant included) are accepted.
+    MoveList moves;
+    generate(moves, GenKind::All, state_.sideToMove, bit(squareOf(from)));
+    for (Move m : moves) {
+        // Auto-promote pawn to queen
+        if (m.to() != squareOf(to) || (m.isPromotion() && m.promotion() != PieceType::Queen))
+            continue;
+        // The undo record is simply dropped: the tools that use this
+        // never take a move back.
+        MoveUndo undo;
+        makeMove(m, undo);
+        return true;
     }
+    return false;
+}
 
-    bool isCastling = (movingPiece->getType() == PieceType::King &&
-                       abs(from.col - to.col) == 2);
-    bool isEP       = (movingPiece->getType() == PieceType::Pawn &&
-                       from.col != to.col && !getPieceAt(to));
+void ChessGame::makeMove(Move move, MoveUndo& undo) {
+    makeMove(move.fromPos(), move.toPos(), undo, move.promotion());
+}
 
-    if (isCastling) {
-        handleCastling(from, to, movingPiece);   // FIX: pass saved ptr
+void ChessGame::makeMove(Position from, Position to, MoveUndo& undo, PieceType promotion) {
+    int fromSq = squareOf(from), toSq = squareOf(to);
+    uint8_t slot = slotAt_[fromSq];
+    Piece&  movingPiece = pieces_[slot];
+    PieceType  type  = movingPiece.type_;
+    PieceColor color = movingPiece.color_;
+
+    undo.from          = from;
+    undo.to            = to;
+    undo.prevEpSquare  = state_.epSquare;
+    undo.prevCastling  = state_.castling;
+    undo.prevHash      = hash_;
+    undo.prevEval      = eval_;
+    // The handlers only write the fields their kind of move uses, so a
+    // reused record must not carry the previous move's over.
+    undo.captured      = MoveUndo::kNoPiece;
+    undo.promotedPawn  = MoveUndo::kNoPiece;
+    undo.rookHadMoved  = false;
+    undo.changes.count = 0;
+    undo.prevHalfmoveClock = state_.halfmoveClock;
+    // The ring entry is handed back on unmake: a line longer than the ring
+    // that is taken back must not leave its keys behind.
+    uint64_t& key = history_[plies_++ & (kHistorySize - 1)];
+    undo.prevHistoryKey = key;
+    key = hash_;
+    undo.movedHadMoved = movingPiece.hasMoved_;
+    undo.isCastling    = (type == PieceType::King && abs(from.col - to.col) == 2);
+
+    slotAt_[fromSq] = MoveUndo::kNoPiece;
+
+    bool isEP = (type == PieceType::Pawn && toSq == state_.epSquare);
+
+    if (undo.isCastling) {
+        handleCastling(from, to, slot, undo);
     } else if (isEP) {
-        handleEnPassant(from, to, movingPiece);  // FIX: pass saved ptr
+        handleEnPassant(from, to, slot, undo);
     } else {
-        removePieceAt(to);
-        movingPiece->setPosition(to);
-        board_[to.row][to.col] = movingPiece;
+        undo.captured = takePieceAt(to);
+        if (undo.captured != MoveUndo::kNoPiece)
+            undo.changes.record(pieces_[undo.captured].color_, pieces_[undo.captured].type_, toSq, false);
+        movingPiece.square_   = uint8_t(toSq);
+        movingPiece.hasMoved_ = true;
+        slotAt_[toSq] = slot;
+        state_.move(color, type, fromSq, toSq);
+        hash_ ^= zobrist::piece(color, type, fromSq) ^ zobrist::piece(color, type, toSq);
+        eval_ -= eval::piece(color, type, fromSq);
+        eval_ += eval::piece(color, type, toSq);
+        undo.changes.record(color, type, fromSq, false);
+        undo.changes.record(color, type, toSq, true);
     }
 
+    hash_ ^= zobrist::castling(state_.castling);
+    state_.castling &= kCastlingMask[fromSq] & kCastlingMask[toSq];
+    hash_ ^= zobrist::castling(state_.castling);
+
     // FIX: Update en passant target for next move.
     // Only a double pawn push creates a valid en passant target.
-    if (movingPiece->getType() == PieceType::Pawn && abs(from.row - to.row) == 2)
-        enPassantTarget_ = Position((from.row + to.row) / 2, from.col);
+    hash_ ^= zobrist::enPassant(state_.epSquare);
+    int epSq = (fromSq + toSq) / 2;
+    if (type == PieceType::Pawn && abs(from.row - to.row) == 2 &&
+        epCapturable(state_, epSq, opponent(color)))
+        state_.epSquare = int8_t(epSq);
     else
-        enPassantTarget_ = Position(-1, -1);
+        state_.epSquare = -1;
+    hash_ ^= zobrist::enPassant(state_.epSquare);
+
+    if (type == PieceType::Pawn && (to.row == 0 || to.row == 7))
+        handlePawnPromotion(to, promotion, undo);
+
+    bool capture = undo.captured != MoveUndo::kNoPiece;
+    state_.halfmoveClock = (type == PieceType::Pawn || capture) ? 0 : state_.halfmoveClock + 1;
+    if (state_.sideToMove == PieceColor::Black) ++state_.fullmoveNumber;
+    state_.sideToMove = opponent(state_.sideToMove);
+    hash_ ^= zobrist::kKeys.blackToMove;
+    verifyHash();
+    verifyEval();
+}
 
-    // Auto-promote pawn to queen
-    if (movingPiece->getType() == PieceType::Pawn && (to.row == 0 || to.row == 7))
-        handlePawnPromotion(to);
+void ChessGame::unmakeMove(MoveUndo& undo) {
+    history_[--plies_ & (kHistorySize - 1)] = undo.prevHistoryKey;
+    state_.sideToMove = opponent(state_.sideToMove);
+    if (state_.sideToMove == PieceColor::Black) --state_.fullmoveNumber;
+    state_.halfmoveClock = undo.prevHalfmoveClock;
+
+    int fromSq = squareOf(undo.from), toSq = squareOf(undo.to);
+    uint8_t slot = slotAt_[toSq];
+    if (undo.promotedPawn != MoveUndo::kNoPiece) {
+        // The promotion piece had the last slot; hand it back.
+        takePieceAt(undo.to);
+        assert(slot == used_ - 1 && "promotions unmade out of order");
+        --used_;
+        slot = undo.promotedPawn;
+        state_.put(pieces_[slot].color_, PieceType::Pawn, toSq);
+    }
+    Piece& piece = pieces_[slot];
+    slotAt_[toSq]   = MoveUndo::kNoPiece;
+    slotAt_[fromSq] = slot;
+    state_.move(piece.color_, piece.type_, toSq, fromSq);
+    piece.square_   = uint8_t(fromSq);
+    piece.hasMoved_ = undo.movedHadMoved;
+
+    if (undo.isCastling) {
+        int base        = fromSq & ~7;
+        int rookFromSq  = base + ((toSq > fromSq) ? 7 : 0);
+        int rookToSq    = (toSq > fromSq) ? toSq - 1 : toSq + 1;
+        uint8_t rookSlot = slotAt_[rookToSq];
+        if (rookSlot != MoveUndo::kNoPiece) {
+            Piece& rook = pieces_[rookSlot];
+            slotAt_[rookToSq]   = MoveUndo::kNoPiece;
+            slotAt_[rookFromSq] = rookSlot;
+            state_.move(rook.color_, PieceType::Rook, rookToSq, rookFromSq);
+            rook.square_   = uint8_t(rookFromSq);
+            rook.hasMoved_ = undo.rookHadMoved;
+        }
+    }
 
-    currentTurn_ = (currentTurn_ == PieceColor::White) ? PieceColor::Black : PieceColor::White;
-    return true;
-}
+    if (undo.captured != MoveUndo::kNoPiece) {
+        const Piece& captured = pieces_[undo.captured];
+        slotAt_[captured.square_] = undo.captured;
+        state_.put(captured.color_, captured.type_, captured.square_);
+    }
 
-// Removes the piece at pos from both pieces_ vector and board_.
-void ChessGame::removePieceAt(Position pos) {
-    if (!pos.isValid() || !board_[pos.row][pos.col]) return;
-    pieces_.erase(
-        remove_if(pieces_.begin(), pieces_.end(),
-            [&](const unique_ptr<Piece>& p) { return p->getPosition() == pos; }),
-        pieces_.end());
-    board_[pos.row][pos.col] = nullptr;
+    state_.epSquare = undo.prevEpSquare;
+    state_.castling = undo.prevCastling;
+    hash_           = undo.prevHash;
+    eval_           = undo.prevEval;
+    verifyHash();
+    verifyEval();
 }
 
-// FIX: king pointer is now passed in (was fetched from board after it was cleared → crash).
-void ChessGame::handleCastling(Position from, Position to, Piece* king) {
-    int row = from.row;
-    int dir = (to.col > from.col) ? 1 : -1;
+// Debug builds (CHESS_VERIFY_HASH) recompute the key from scratch after every
+// make/unmake and stop at the first divergence from the incremental one.
+void ChessGame::verifyHash() const {
+#ifdef CHESS_VERIFY_HASH
+    assert(hash_ == zobrist::hashOf(state_) && "incremental Zobrist key diverged");
+#endif
+}
 
-    king->setPosition(to);
-    board_[to.row][to.col] = king;
+// The same for the evaluation terms, under CHESS_VERIFY_EVAL.
+void ChessGame::verifyEval() const {
+#ifdef CHESS_VERIFY_EVAL
+    assert(eval_ == eval::termsOf(state_) && "incremental evaluation terms diverged");
+#endif
+}
 
-    int rookFromCol = (dir == 1) ? 7 : 0;
-    int rookToCol   = (dir == 1) ? to.col - 1 : to.col + 1;
+// Takes the piece at pos off the board (slotAt_, state_, key and terms) and
+// returns its slot, or kNoPiece for an empty square. The piece itself stays
+// in the pool with its last square, ready to be put back.
+uint8_t ChessGame::takePieceAt(Position pos) {
+    if (!pos.isValid()) return MoveUndo::kNoPiece;
+    int sq = squareOf(pos);
+    uint8_t slot = slotAt_[sq];
+    if (slot == MoveUndo::kNoPiece) return slot;
+    const Piece& target = pieces_[slot];
+    slotAt_[sq] = MoveUndo::kNoPiece;
+    state_.remove(target.color_, target.type_, sq);
+    hash_ ^= zobrist::piece(target.color_, target.type_, sq);
+    eval_ -= eval::piece(target.color_, target.type_, sq);
+    return slot;
+}
 
-    Piece* rook = getPieceAt(Position(row, rookFromCol));
-    if (rook) {
-        rook->setPosition(Position(row, rookToCol));
-        board_[row][rookFromCol] = nullptr;
-        board_[row][rookToCol]   = rook;
+void ChessGame::handleCastling(Position from, Position to, uint8_t king, MoveUndo& undo) {
+    int row = from.row;
+    int dir = (to.col > from.col) ? 1 : -1;
+    PieceColor color = pieces_[king].color_;
+
+    pieces_[king].square_   = uint8_t(squareOf(to));
+    pieces_[king].hasMoved_ = true;
+    slotAt_[squareOf(to)] = king;
+    state_.move(color, PieceType::King, squareOf(from), squareOf(to));
+    hash_ ^= zobrist::piece(color, PieceType::King, squareOf(from))
+           ^ zobrist::piece(color, PieceType::King, squareOf(to));
+    eval_ -= eval::piece(color, PieceType::King, squareOf(from));
+    eval_ += eval::piece(color, PieceType::King, squareOf(to));
+    undo.changes.record(color, PieceType::King, squareOf(from), false);
+    undo.changes.record(color, PieceType::King, squareOf(to), true);
+
+    int rookFromSq = row * 8 + ((dir == 1) ? 7 : 0);
+    int rookToSq   = row * 8 + ((dir == 1) ? to.col - 1 : to.col + 1);
+
+    uint8_t rook = slotAt_[rookFromSq];
+    if (rook != MoveUndo::kNoPiece) {
+        undo.rookHadMoved = pieces_[rook].hasMoved_;
+        pieces_[rook].square_   = uint8_t(rookToSq);
+        pieces_[rook].hasMoved_ = true;
+        slotAt_[rookFromSq] = MoveUndo::kNoPiece;
+        slotAt_[rookToSq]   = rook;
+        state_.move(color, PieceType::Rook, rookFromSq, rookToSq);
+        hash_ ^= zobrist::piece(color, PieceType::Rook, rookFromSq)
+               ^ zobrist::piece(color, PieceType::Rook, rookToSq);
+        eval_ -= eval::piece(color, PieceType::Rook, rookFromSq);
+        eval_ += eval::piece(color, PieceType::Rook, rookToSq);
+        undo.changes.record(color, PieceType::Rook, rookFromSq, false);
+        undo.changes.record(color, PieceType::Rook, rookToSq, true);
     }
 }
 
-// FIX: pawn pointer is now passed in (was fetched from board after it was cleared → crash).
-void ChessGame::handleEnPassant(Position from, Position to, Piece* pawn) {
-    // Remove the captured pawn (same row as 'from', same col as 'to')
-    removePieceAt(Position(from.row, to.col));
-    pawn->setPosition(to);
-    board_[to.row][to.col] = pawn;
+void ChessGame::handleEnPassant(Position from, Position to, uint8_t pawn, MoveUndo& undo) {
+    // Capture the pawn (same row as 'from', same col as 'to')
+    undo.captured = takePieceAt(Position(from.row, to.col));
+    PieceColor color = pieces_[pawn].color_;
+    if (undo.captured != MoveUndo::kNoPiece)
+        undo.changes.record(opponent(color), PieceType::Pawn, from.row * 8 + to.col, false);
+    pieces_[pawn].square_   = uint8_t(squareOf(to));
+    pieces_[pawn].hasMoved_ = true;
+    slotAt_[squareOf(to)] = pawn;
+    state_.move(color, PieceType::Pawn, squareOf(from), squareOf(to));
+    hash_ ^= zobrist::piece(color, PieceType::Pawn, squareOf(from))
+           ^ zobrist::piece(color, PieceType::Pawn, squareOf(to));
+    eval_ -= eval::piece(color, PieceType::Pawn, squareOf(from));
+    eval_ += eval::piece(color, PieceType::Pawn, squareOf(to));
+    undo.changes.record(color, PieceType::Pawn, squareOf(from), false);
+    undo.changes.record(color, PieceType::Pawn, squareOf(to), true);
 }
 
-void ChessGame::handlePawnPromotion(Position pos) {
-    Piece* pawn = getPieceAt(pos);
-    if (!pawn || pawn->getType() != PieceType::Pawn) return;
-    PieceColor color = pawn->getColor();
-    removePieceAt(pos);
-    auto queen = make_unique<Queen>(color, pos);
-    board_[pos.row][pos.col] = queen.get();
-    pieces_.push_back(move(queen));
+// The pawn stays parked in its slot; the new piece takes the next free one.
+void ChessGame::handlePawnPromotion(Position pos, PieceType promotion, MoveUndo& undo) {
+    int sq = squareOf(pos);
+    uint8_t pawn = slotAt_[sq];
+    if (pawn == MoveUndo::kNoPiece || pieces_[pawn].type_ != PieceType::Pawn) return;
+    if (promotion == PieceType::None) return;
+    assert(used_ < kPoolSize && "piece pool exhausted");
+    PieceColor color = pieces_[pawn].color_;
+    undo.promotedPawn = takePieceAt(pos);
+    uint8_t slot = used_++;
+    pieces_[slot] = Piece(promotion, color, pos);
+    slotAt_[sq] = slot;
+    state_.put(color, promotion, sq);
+    hash_ ^= zobrist::piece(color, promotion, sq);
+    eval_ += eval::piece(color, promotion, sq);
+    undo.changes.record(color, PieceType::Pawn, sq, false);
+    undo.changes.record(color, promotion, sq, true);
 }
 
 bool ChessGame::isCheckmate(PieceColor color) const {
@@ -470,17 +814,7 @@ bool ChessGame::isStalemate(PieceColor color) const {
 }
 
 bool ChessGame::hasLegalMoves(PieceColor color) const {
-    for (const auto& piece : pieces_) {
-        if (piece->getColor() != color) continue;
-        for (const auto& to : getRawMoves(piece.get())) {
-            if (isMoveLegal(piece->getPosition(), to))
-                return true;
-        }
-        // Also check castling for king (rare but necessary for correctness)
-        if (piece->getType() == PieceType::King) {
-            auto kingMoves = getValidMoves(piece->getPosition());
-            if (!kingMoves.empty()) return true;
-        }
-    }
-    return false;
-}
\ No newline at end of file
+    MoveList moves;
+    generate(moves, GenKind::All, color, ~Bitboard(0), true);
+    return !moves.empty();
+}
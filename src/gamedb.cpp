@@ -0,0 +1,298 @@
+#include "gamedb.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+GameResult resultFromText(string_view text) {
+    if (text == "1-0")     return GameResult::WhiteWins;
+    if (text == "0-1")     return GameResult::BlackWins;
+    if (text == "1/2-1/2") return GameResult::Draw;
+    return GameResult::Unknown;
+}
+
+string_view resultText(GameResult result) {
+    switch (result) {
+    case GameResult::WhiteWins: return "1-0";
+    case GameResult::BlackWins: return "0-1";
+    case GameResult::Draw:      return "1/2-1/2";
+    default:                    return "*";
+    }
+}
+
+static const char kBinMagic[4]   = { 'C', 'G', 'D', 'B' };
+static const char kIndexMagic[4] = { 'C', 'G', 'D', 'X' };
+
+static void putVarint(string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out += char(v | 0x80);
+        v >>= 7;
+    }
+    out += char(v);
+}
+
+static bool getVarint(const char*& p, const char* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = uint8_t(*p++);
+        v |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Rank of move among the legal moves by 16-bit code, and the reverse.
+static int moveRank(const MoveList& legal, Move move) {
+    int rank = 0;
+    bool found = false;
+    for (Move m : legal) {
+        rank  += m.raw() < move.raw();
+        found |= m == move;
+    }
+    return found ? rank : -1;
+}
+
+static Move moveAtRank(MoveList& legal, int rank) {
+    if (rank >= legal.size()) return Move::none();
+    nth_element(legal.begin(), legal.begin() + rank, legal.end(),
+                [](Move a, Move b) { return a.raw() < b.raw(); });
+    return legal[rank];
+}
+
+// ── writer ────────────────────────────────────────────────────────────────────
+
+bool GameDatabaseWriter::open(const string& basePath) {
+    close();
+    entries_.clear();
+    ids_.clear();
+    strings_.clear();
+    offset_    = 0;
+    indexPath_ = basePath + ".idx";
+    string binPath = basePath + ".bin";
+    if (!(bin_ = fopen(binPath.c_str(), "wb"))) {
+        error_ = "cannot write " + binPath;
+        return false;
+    }
+    uint32_t version = gamedb::kVersion;
+    fwrite(kBinMagic, 1, 4, bin_);
+    fwrite(&version, 4, 1, bin_);
+    offset_ = 8;
+    return true;
+}
+
+uint32_t GameDatabaseWriter::intern(string_view s) {
+    key_.assign(s.data(), s.size());   // reused, so a hit does not allocate
+    auto it = ids_.find(key_);
+    if (it != ids_.end()) return it->second;
+    it = ids_.emplace(key_, uint32_t(strings_.size())).first;
+    strings_.push_back(&it->first);
+    return it->second;
+}
+
+bool GameDatabaseWriter::add(const vector<PgnTag>& tags, const vector<Move>& moves) {
+    if (!bin_ || tags.size() > 0xFFFF) return false;
+
+    string_view fen, result;
+    for (const PgnTag& t : tags) {
+        if (t.name == "FEN")    fen = t.value;
+        if (t.name == "Result") result = t.value;
+    }
+    if (fen.empty()) game_.initializeBoard();
+    else if (!game_.fromFEN(fen)) return false;
+
+    // Moves first: nothing may be interned for a game that is rejected.
+    string moveBytes;
+    moveBytes.reserve(moves.size());
+    for (Move m : moves) {
+        MoveList legal;
+        game_.generateLegalMoves(legal);
+        int rank = moveRank(legal, m);
+        if (rank < 0) return false;
+        moveBytes += char(rank);
+        MoveUndo undo;
+        game_.makeMove(m, undo);
+    }
+
+    // Strings new to this game are taken back if the record is not written.
+    size_t known = strings_.size();
+    record_.clear();
+    putVarint(record_, tags.size());
+    for (const PgnTag& t : tags) {
+        putVarint(record_, intern(t.name));
+        putVarint(record_, intern(t.value));
+    }
+    record_ += moveBytes;
+    if (fwrite(record_.data(), 1, record_.size(), bin_) != record_.size()) {
+        while (strings_.size() > known) {
+            ids_.erase(ids_.find(*strings_.back()));
+            strings_.pop_back();
+        }
+        error_ = "write failed";
+        return false;
+    }
+
+    gamedb::IndexEntry e{};
+    e.offset   = offset_;
+    e.plies    = uint32_t(moves.size());
+    e.tagCount = uint16_t(tags.size());
+    e.result   = resultFromText(result);
+    entries_.push_back(e);
+    offset_ += record_.size();
+    return true;
+}
+
+bool GameDatabaseWriter::close() {
+    if (!bin_) return true;
+    bool ok = fclose(bin_) == 0;
+    bin_ = nullptr;
+
+    FILE* idx = fopen(indexPath_.c_str(), "wb");
+    if (!idx) {
+        error_ = "cannot write " + indexPath_;
+        return false;
+    }
+    gamedb::IndexHeader h{};
+    memcpy(h.magic, kIndexMagic, 4);
+    h.version       = gamedb::kVersion;
+    h.games         = entries_.size();
+    h.strings       = strings_.size();
+    h.stringOffsets = sizeof h + entries_.size() * sizeof(gamedb::IndexEntry);   // 8-aligned
+
+    vector<uint64_t> offsets;
+    offsets.reserve(strings_.size() + 1);
+    uint64_t pos = 0;
+    for (const string* s : strings_) {
+        offsets.push_back(pos);
+        pos += s->size();
+    }
+    offsets.push_back(pos);
+
+    ok &= fwrite(&h, sizeof h, 1, idx) == 1;
+    ok &= fwrite(entries_.data(), sizeof(gamedb::IndexEntry), entries_.size(), idx) == entries_.size();
+    ok &= fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), idx) == offsets.size();
+    for (const string* s : strings_) ok &= fwrite(s->data(), 1, s->size(), idx) == s->size();
+    ok &= fclose(idx) == 0;
+    if (!ok) error_ = "write failed";
+    return ok;
+}
+
+// ── reader ────────────────────────────────────────────────────────────────────
+
+bool GameDatabase::fail(string message) {
+    close();
+    error_ = move(message);
+    return false;
+}
+
+bool GameDatabase::open(const string& basePath) {
+    close();
+    if (!bin_.open(basePath + ".bin", MappedFile::Access::Random)) return fail(bin_.error());
+    if (!idx_.open(basePath + ".idx", MappedFile::Access::Random)) return fail(idx_.error());
+
+    string_view bin = bin_.view(), idx = idx_.view();
+    if (bin.size() < 8 || memcmp(bin.data(), kBinMagic, 4) != 0)
+        return fail(basePath + ".bin: not a game database");
+    if (idx.size() < sizeof(gamedb::IndexHeader) || memcmp(idx.data(), kIndexMagic, 4) != 0)
+        return fail(basePath + ".idx: not a game database index");
+
+    auto h = reinterpret_cast<const gamedb::IndexHeader*>(idx.data());
+    if (h->version != gamedb::kVersion) return fail(basePath + ".idx: unsupported version");
+    // Counts are bounded by the file size first, so the sizes below cannot overflow.
+    uint64_t room = idx.size() - sizeof *h;
+    if (h->games > room / sizeof(gamedb::IndexEntry) || h->strings >= room / sizeof(uint64_t))
+        return fail(basePath + ".idx: truncated");
+    uint64_t entriesEnd = sizeof *h + h->games * sizeof(gamedb::IndexEntry);
+    uint64_t stringsAt  = h->stringOffsets + (h->strings + 1) * sizeof(uint64_t);
+    if (h->stringOffsets != entriesEnd || stringsAt > idx.size())
+        return fail(basePath + ".idx: truncated");
+
+    // Everything the readers index with is checked once here, so a
+    // truncated or corrupt file fails to open instead of being read out of
+    // bounds: records lie in order inside .bin, each long enough for its
+    // moves, and strings are consecutive slices of the string block.
+    auto entries = reinterpret_cast<const gamedb::IndexEntry*>(idx.data() + sizeof *h);
+    for (uint64_t i = 0; i < h->games; ++i) {
+        uint64_t begin = entries[i].offset;
+        uint64_t end   = i + 1 < h->games ? entries[i + 1].offset : bin.size();
+        if (begin < 8 || end > bin.size() || begin >= end || end - begin <= entries[i].plies)
+            return fail(basePath + ".idx: game " + to_string(i + 1) + " does not fit the .bin file");
+    }
+    auto offsets = reinterpret_cast<const uint64_t*>(idx.data() + h->stringOffsets);
+    if (offsets[0] != 0 || offsets[h->strings] > idx.size() - stringsAt)
+        return fail(basePath + ".idx: truncated");
+    for (uint64_t i = 0; i < h->strings; ++i)
+        if (offsets[i] > offsets[i + 1]) return fail(basePath + ".idx: corrupt string table");
+
+    header_        = h;
+    entries_       = entries;
+    stringOffsets_ = offsets;
+    stringBytes_   = idx.data() + stringsAt;
+    return true;
+}
+
+// Where the game's record ends: at the next one, or at the end of .bin.
+const char* GameDatabase::recordEnd(size_t game) const {
+    return bin_.view().data() + (game + 1 < size() ? entries_[game + 1].offset : bin_.size());
+}
+
+void GameDatabase::close() {
+    header_        = nullptr;
+    entries_       = nullptr;
+    stringOffsets_ = nullptr;
+    stringBytes_   = nullptr;
+    bin_.close();
+    idx_.close();
+}
+
+string_view GameDatabase::stringAt(uint64_t id) const {
+    if (!header_ || id >= header_->strings) return {};
+    return { stringBytes_ + stringOffsets_[id], size_t(stringOffsets_[id + 1] - stringOffsets_[id]) };
+}
+
+bool GameDatabase::tags(size_t game, vector<PgnTag>& out) const {
+    out.clear();
+    if (game >= size()) return false;
+    const char* p   = bin_.view().data() + entries_[game].offset;
+    const char* end = recordEnd(game);
+    uint64_t count, name, value;
+    if (!getVarint(p, end, count)) return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!getVarint(p, end, name) || !getVarint(p, end, value) ||
+            name >= header_->strings || value >= header_->strings)
+            return false;
+        out.push_back({ stringAt(name), stringAt(value) });
+    }
+    return true;
+}
+
+bool GameDatabase::moves(size_t game, ChessGame& board, vector<Move>& out) const {
+    out.clear();
+    if (game >= size()) return false;
+    const gamedb::IndexEntry& e = entries_[game];
+    const char* p   = bin_.view().data() + e.offset;
+    const char* end = recordEnd(game);
+
+    // Skip the tags, picking up a FEN on the way.
+    uint64_t count, name, value;
+    string_view fen;
+    if (!getVarint(p, end, count)) return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!getVarint(p, end, name) || !getVarint(p, end, value)) return false;
+        if (stringAt(name) == "FEN") fen = stringAt(value);
+    }
+    if (uint64_t(end - p) < e.plies) return false;
+
+    if (fen.empty()) board.initializeBoard();
+    else if (!board.fromFEN(fen)) return false;
+    out.reserve(e.plies);
+    for (uint32_t i = 0; i < e.plies; ++i) {
+        MoveList legal;
+        board.generateLegalMoves(legal);
+        Move m = moveAtRank(legal, uint8_t(p[i]));
+        if (m == Move::none()) return false;
+        MoveUndo undo;
+        board.makeMove(m, undo);
+        out.push_back(m);
+    }
+    return true;
+}
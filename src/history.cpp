@@ -0,0 +1,39 @@
+#include "history.h"
+#include <algorithm>
+
+using namespace std;
+
+void MoveHistory::clear() {
+    line_.clear();
+    undo_.clear();
+}
+
+void MoveHistory::play(ChessGame& game, Move move) {
+    if (ply() < length() && line_[size_t(ply())] == move) {
+        redo(game);
+        return;
+    }
+    line_.resize(size_t(ply()));
+    line_.push_back(move);
+    redo(game);
+}
+
+bool MoveHistory::undo(ChessGame& game) {
+    if (undo_.empty()) return false;
+    game.unmakeMove(undo_.back());
+    undo_.pop_back();
+    return true;
+}
+
+bool MoveHistory::redo(ChessGame& game) {
+    if (ply() >= length()) return false;
+    undo_.emplace_back();
+    game.makeMove(line_[size_t(ply()) - 1], undo_.back());
+    return true;
+}
+
+void MoveHistory::jumpTo(ChessGame& game, int target) {
+    target = clamp(target, 0, length());
+    while (ply() > target) undo(game);
+    while (ply() < target) redo(game);
+}
@@ -7,6 +7,7 @@ int main(int argc, char *argv[])
     QApplication app(argc, argv);
 
     MainWindow window;
+    window.setFrameTiming(app.arguments().contains("--frame-times"));
     window.show();
     return app.exec();
 }
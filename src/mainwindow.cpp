@@ -3,9 +3,13 @@
 #include <QMouseEvent>
 #include <QMessageBox>
 #include <QStatusBar>
+#include <QMenuBar>
+#include <QAction>
 #include <QTimer>
+#include <QtConcurrent>
 #include <QFont>
 #include <QDebug>
+#include <QElapsedTimer>
 
 // ── board palette (classic wooden look) ──────────────────────────────────────
 static const QColor kLightSquare (240, 217, 181);   // cream
@@ -16,10 +20,20 @@ static const QColor kMoveSq      ( 80, 200,  80, 140);   // green – empty vali
 static const QColor kCaptureSq   (210,  40,  40, 200);   // RED  – enemy piece (will be captured)
 static const QColor kCheckSq     (255,  50,  50, 220);   // bright red – king in check
 
+// Thinking time per computer move.
+static const int kEngineMoveTimeMs = 1000;
+
+// Positions kept in the analysis cache (about 0.5 KB each) before it is
+// emptied; re-analysing a position on the way back is a few microseconds.
+static const size_t kAnalysisCacheSize = 4096;
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
       selectedPos(-1, -1),
-      updateTimer(new QTimer(this)) {
+      updateTimer(new QTimer(this)),
+      analysisWatcher(new QFutureWatcher<PositionAnalysis>(this)),
+      computerBlackAction(nullptr),
+      engineWatcher(new QFutureWatcher<SearchResult>(this)) {
 
     // Board area: 8×70 = 560px + 20px border each side = 600px wide
     // Height: 560 + 50 top (status) + 50 bottom (coords+bar) = 660
@@ -46,28 +60,142 @@ MainWindow::MainWindow(QWidget *parent)
         QMessageBox QPushButton:hover { background-color: #a0714f; }
     )");
 
+    QMenu* gameMenu = menuBar()->addMenu("&Game");
+    computerBlackAction = gameMenu->addAction("Computer plays &Black");
+    computerBlackAction->setCheckable(true);
+    connect(computerBlackAction, &QAction::toggled, this, [this](bool on) {
+        if (on) updateGameStatus();
+        else    stopEngine();   // onEngineMove then drops the result
+    });
+
+    // Move history: undo/redo a ply (a full move against the computer),
+    // and jump back and forth through the game.
+    gameMenu->addSeparator();
+    QAction* undoAction = gameMenu->addAction("&Undo Move");
+    undoAction->setShortcuts(QKeySequence::Undo);
+    connect(undoAction, &QAction::triggered, this, &MainWindow::takeBack);
+    QAction* redoAction = gameMenu->addAction("&Redo Move");
+    redoAction->setShortcuts(QKeySequence::Redo);
+    connect(redoAction, &QAction::triggered, this, &MainWindow::stepForward);
+    QAction* backAction = gameMenu->addAction("Previous Position");
+    backAction->setShortcut(QKeySequence(Qt::Key_Left));
+    connect(backAction, &QAction::triggered, this, [this] { jumpToPly(history.ply() - 1); });
+    QAction* forwardAction = gameMenu->addAction("Next Position");
+    forwardAction->setShortcut(QKeySequence(Qt::Key_Right));
+    connect(forwardAction, &QAction::triggered, this, [this] { jumpToPly(history.ply() + 1); });
+    QAction* startAction = gameMenu->addAction("Go to Start");
+    startAction->setShortcut(QKeySequence(Qt::Key_Home));
+    connect(startAction, &QAction::triggered, this, [this] { jumpToPly(0); });
+    QAction* endAction = gameMenu->addAction("Go to End");
+    endAction->setShortcut(QKeySequence(Qt::Key_End));
+    connect(endAction, &QAction::triggered, this, [this] { jumpToPly(history.length()); });
+
+    connect(engineWatcher, &QFutureWatcher<SearchResult>::finished,
+            this, &MainWindow::onEngineMove);
+    connect(analysisWatcher, &QFutureWatcher<PositionAnalysis>::finished,
+            this, &MainWindow::onAnalysisReady);
+
     updateTimer->setSingleShot(true);
     connect(updateTimer, &QTimer::timeout, this, &MainWindow::updateGameStatus);
+    refreshBoard();
     updateGameStatus();
 }
 
-MainWindow::~MainWindow() {}
+MainWindow::~MainWindow() {
+    // The worker references searcher; let it unwind before members go away.
+    searcher.stop();
+    engineWatcher->waitForFinished();
+    analysisWatcher->waitForFinished();
+}
 
 // ── painting ──────────────────────────────────────────────────────────────────
 
-void MainWindow::paintEvent(QPaintEvent*) {
+// Board offset: leave 30px left for rank numbers, 55px top for title bar area
+static const int OX = 30;   // x offset
+static const int OY = 55;   // y offset
+
+static QRect squareRect(int sq) {
+    return QRect(OX + (sq % 8)*70, OY + (7 - sq / 8)*70, 70, 70);
+}
+
+// Only the squares inside the exposed area are redrawn; the board layer
+// beneath them is a single blit of the matching slice.
+void MainWindow::paintEvent(QPaintEvent* event) {
+    QElapsedTimer frameTimer;
+    if (frameTiming) frameTimer.start();
+
+    // Lazily (re)built: first paint, or the window moved to a screen with
+    // a different device pixel ratio.
+    if (layerDpr != devicePixelRatioF()) {
+        layerDpr = devicePixelRatioF();
+        buildPieceAtlas();
+        buildBoardLayer();
+    }
+
+    QRect dirty = event->rect();
+    Bitboard visible = 0;
+    for (int sq = 0; sq < 64; ++sq)
+        if (squareRect(sq).intersects(dirty)) visible |= bit(sq);
+
     QPainter painter(this);
     painter.setRenderHint(QPainter::Antialiasing);
+    painter.drawPixmap(dirty, boardLayer,
+                       QRect(qRound(dirty.x() * layerDpr), qRound(dirty.y() * layerDpr),
+                             qRound(dirty.width() * layerDpr), qRound(dirty.height() * layerDpr)));
+    drawHighlights(painter, visible);
+    drawPieces(painter, visible);
+
+    if (frameTiming) {
+        painter.end();
+        qint64 ns = frameTimer.nsecsElapsed();
+        frameNsTotal += ns;
+        frameNsMax    = std::max(frameNsMax, ns);
+        if (++frameCount == 60) {
+            qInfo() << "paintEvent:" << frameCount << "frames, mean"
+                    << frameNsTotal / frameCount / 1000.0 << "us, max" << frameNsMax / 1000.0 << "us";
+            frameCount = 0;
+            frameNsTotal = frameNsMax = 0;
+        }
+    }
+}
+
+// Decodes the piece PNGs from the resources once and scales each, smoothly,
+// to a 64×64-logical-pixel cell of one pixmap; drawPieces() then only blits
+// sub-rectangles of it.
+void MainWindow::buildPieceAtlas() {
+    static const char* const kColors[] = { "white", "black" };
+    static const char* const kTypes[]  = { "pawn", "rook", "knight", "bishop", "queen", "king" };
+
+    atlasCell  = qRound(64 * layerDpr);
+    pieceAtlas = QPixmap(6 * atlasCell, 2 * atlasCell);
+    pieceAtlas.fill(Qt::transparent);
+
+    QPainter painter(&pieceAtlas);
+    for (int color = 0; color < 2; ++color)
+        for (int type = 0; type < 6; ++type) {
+            QString path = QString(":Images/assets/%1_%2.png").arg(kColors[color]).arg(kTypes[type]);
+            QPixmap px(path);
+            if (px.isNull()) { qDebug() << "Missing image:" << path; continue; }
+            painter.drawPixmap(type * atlasCell, color * atlasCell,
+                               px.scaled(atlasCell, atlasCell, Qt::KeepAspectRatio,
+                                         Qt::SmoothTransformation));
+        }
+}
+
+// The parts of the window that never change — wooden border, squares,
+// coordinates — rendered once at device resolution. Transparent elsewhere
+// so the styled window background shows through.
+void MainWindow::buildBoardLayer() {
+    boardLayer = QPixmap(qRound(width() * layerDpr), qRound(height() * layerDpr));
+    boardLayer.setDevicePixelRatio(layerDpr);
+    boardLayer.fill(Qt::transparent);
+
+    QPainter painter(&boardLayer);
+    painter.setRenderHint(QPainter::Antialiasing);
     drawBoard(painter);
     drawCoordinates(painter);
-    drawHighlights(painter);
-    drawPieces(painter);
 }
 
-// Board offset: leave 30px left for rank numbers, 55px top for title bar area
-static const int OX = 30;   // x offset
-static const int OY = 55;   // y offset
-
 void MainWindow::drawBoard(QPainter& painter) {
     // Outer wooden border
     painter.setPen(Qt::NoPen);
@@ -104,82 +232,74 @@ void MainWindow::drawCoordinates(QPainter& painter) {
     }
 }
 
-void MainWindow::drawHighlights(QPainter& painter) {
+// Highlights and pieces are drawn from drawnView — the snapshot the last
+// refreshBoard() invalidated for — so an expose repaint matches it exactly.
+void MainWindow::drawHighlights(QPainter& painter, Bitboard visible) {
+    const BoardView& v = drawnView;
     painter.setPen(Qt::NoPen);
 
     // Selected square — gold
-    if (selectedPos.isValid()) {
-        painter.setBrush(kSelectedSq);
-        painter.drawRect(OX + selectedPos.col*70,
-                         OY + (7 - selectedPos.row)*70,
-                         70, 70);
-    }
+    painter.setBrush(kSelectedSq);
+    for (Bitboard b = v.selected & visible; b; )
+        painter.drawRect(squareRect(popLsb(b)));
 
     // Valid moves: green for empty squares, RED for captures
-    for (const auto& m : validMoves) {
-        bool isCapture = std::find(captureMoves.begin(),
-                                   captureMoves.end(), m) != captureMoves.end();
-        painter.setBrush(isCapture ? kCaptureSq : kMoveSq);
-        painter.drawRect(OX + m.col*70, OY + (7 - m.row)*70, 70, 70);
+    for (Bitboard b = v.moves & visible; b; ) {
+        int sq = popLsb(b);
+        painter.setBrush((v.captures & bit(sq)) ? kCaptureSq : kMoveSq);
+        painter.drawRect(squareRect(sq));
     }
 
     // King-in-check: flash the king's square bright red
-    PieceColor toMove = game.getCurrentTurn();
-    if (game.isKingInCheck(toMove)) {
-        // Find the king square
-        for (int r = 0; r < 8; ++r)
-            for (int c = 0; c < 8; ++c) {
-                Piece* p = game.getPieceAt(Position(r, c));
-                if (p && p->getType() == PieceType::King
-                      && p->getColor() == toMove) {
-                    painter.setBrush(kCheckSq);
-                    painter.drawRect(OX + c*70, OY + (7-r)*70, 70, 70);
-                }
-            }
-    }
+    painter.setBrush(kCheckSq);
+    for (Bitboard b = v.check & visible; b; )
+        painter.drawRect(squareRect(popLsb(b)));
 
     // Small dots on empty valid-move squares (chess.com style)
     painter.setBrush(QColor(0, 0, 0, 50));
-    for (const auto& m : validMoves) {
-        bool isCapture = std::find(captureMoves.begin(),
-                                   captureMoves.end(), m) != captureMoves.end();
-        if (!isCapture) {
-            // Draw a small centered dot
-            int cx = OX + m.col*70 + 35;
-            int cy = OY + (7 - m.row)*70 + 35;
-            painter.drawEllipse(cx - 10, cy - 10, 20, 20);
-        }
+    for (Bitboard b = v.moves & ~v.captures & visible; b; ) {
+        QRect r = squareRect(popLsb(b));
+        painter.drawEllipse(r.x() + 25, r.y() + 25, 20, 20);
     }
 }
 
-void MainWindow::drawPieces(QPainter& painter) {
-    for (int r = 0; r < 8; ++r) {
-        for (int c = 0; c < 8; ++c) {
-            Piece* piece = game.getPieceAt(Position(r, c));
-            if (!piece) continue;
-
-            QString color = (piece->getColor() == PieceColor::White) ? "white" : "black";
-            QString type;
-            switch (piece->getType()) {
-            case PieceType::Pawn:   type = "pawn";   break;
-            case PieceType::Rook:   type = "rook";   break;
-            case PieceType::Knight: type = "knight"; break;
-            case PieceType::Bishop: type = "bishop"; break;
-            case PieceType::Queen:  type = "queen";  break;
-            case PieceType::King:   type = "king";   break;
-            default: continue;
-            }
-
-            QString path = QString(":Images/assets/%1_%2.png").arg(color).arg(type);
-            QPixmap px(path);
-            if (px.isNull()) { qDebug() << "Missing image:" << path; continue; }
+void MainWindow::drawPieces(QPainter& painter, Bitboard visible) {
+    // pieceIndex order (colour * 6 + type - 1) is also the atlas layout.
+    for (int i = 0; i < 12; ++i)
+        for (Bitboard b = drawnView.pieces[i] & visible; b; ) {
+            QRect sq = squareRect(popLsb(b));
+            QRect sprite((i % 6) * atlasCell, (i / 6) * atlasCell, atlasCell, atlasCell);
 
             // Draw with a tiny 3px padding so pieces don't touch square edges
-            painter.drawPixmap(OX + c*70 + 3,
-                               OY + (7-r)*70 + 3,
-                               64, 64, px);
+            painter.drawPixmap(sq.adjusted(3, 3, -3, -3), pieceAtlas, sprite);
         }
-    }
+}
+
+// What the board should show now, as square sets.
+MainWindow::BoardView MainWindow::currentView() const {
+    BoardView v;
+    for (int i = 0; i < 12; ++i) v.pieces[i] = game.state().pieces[i];
+    if (selectedPos.isValid()) v.selected = bit(squareOf(selectedPos));
+    for (const auto& m : validMoves)   v.moves    |= bit(squareOf(m));
+    for (const auto& m : captureMoves) v.captures |= bit(squareOf(m));
+    // From the cached analysis — painting never asks the engine.
+    const PositionAnalysis* a = currentAnalysis();
+    if (a && a->inCheck && a->kingSquare >= 0) v.check = bit(a->kingSquare);
+    return v;
+}
+
+// Repaints exactly the squares whose content differs from what is on screen:
+// moved, captured and promoted pieces (castling rook and en passant victim
+// included, since they are ordinary bitboard changes), selection, move and
+// capture overlays, and the check square.
+void MainWindow::refreshBoard() {
+    BoardView next = currentView();
+    Bitboard changed = (next.selected ^ drawnView.selected) | (next.moves ^ drawnView.moves)
+                     | (next.captures ^ drawnView.captures) | (next.check ^ drawnView.check);
+    for (int i = 0; i < 12; ++i) changed |= next.pieces[i] ^ drawnView.pieces[i];
+
+    drawnView = next;
+    while (changed) update(squareRect(popLsb(changed)));
 }
 
 // ── input ─────────────────────────────────────────────────────────────────────
@@ -189,66 +309,197 @@ void MainWindow::mousePressEvent(QMouseEvent* event) {
     int row = 7 - ((int)event->position().y() - OY) / 70;
     Position clicked(row, col);
     if (!clicked.isValid()) return;
+    if (engineToMove() || engineWatcher->isRunning()) return;   // computer is thinking
+    // A drawn game is over, like mate and stalemate (which leave no moves);
+    // undo and history navigation still work.
+    if (game.drawReason() != ChessGame::DrawReason::None) return;
 
-    if (std::find(validMoves.begin(), validMoves.end(), clicked) != validMoves.end()) {
-        // Execute move
-        game.movePiece(selectedPos, clicked);
-        selectedPos = Position(-1, -1);
-        validMoves.clear();
-        captureMoves.clear();
-        updateTimer->start(0);
+    const PositionAnalysis* current = currentAnalysis();
+    if (current && std::find(validMoves.begin(), validMoves.end(), clicked) != validMoves.end()) {
+        // Execute move (auto-promote to a queen)
+        for (Move m : current->moves)
+            if (m.fromPos() == selectedPos && m.toPos() == clicked &&
+                (!m.isPromotion() || m.promotion() == PieceType::Queen)) {
+                playMove(m);
+                return;
+            }
     } else {
-        Piece* piece = game.getPieceAt(clicked);
-        if (piece && piece->getColor() == game.getCurrentTurn()) {
+        const Piece* piece = game.getPieceAt(clicked);
+        const PositionAnalysis* a = currentAnalysis();
+        if (a && piece && piece->getColor() == game.getCurrentTurn()) {
             selectedPos  = clicked;
-            validMoves   = game.getValidMoves(clicked);
 
-            // ── NEW: populate captureMoves ──────────────────────────────────
-            // A move is a capture if the destination has an enemy piece,
-            // OR it matches the en passant target (pawn diagonal to empty square).
+            // The analysed move list gives both lists: the move flags
+            // already say which destinations capture (en passant included
+            // → RED). Promotions are listed once per destination (auto-queen).
+            validMoves.clear();
             captureMoves.clear();
-            for (const auto& m : validMoves) {
-                Piece* target = game.getPieceAt(m);
-                if (target && target->getColor() != piece->getColor()) {
-                    captureMoves.push_back(m);   // normal capture → RED
-                } else if (piece->getType() == PieceType::Pawn &&
-                           m.col != clicked.col &&
-                           !target) {
-                    captureMoves.push_back(m);   // en passant → also RED
-                }
+            for (Move m : a->moves) {
+                if (m.fromPos() != clicked) continue;
+                if (m.isPromotion() && m.promotion() != PieceType::Queen) continue;
+                validMoves.push_back(m.toPos());
+                if (m.isCapture())
+                    captureMoves.push_back(m.toPos());
             }
-            // ───────────────────────────────────────────────────────────────
         } else {
             selectedPos = Position(-1, -1);
             validMoves.clear();
             captureMoves.clear();
         }
     }
-    update();
+    refreshBoard();
 }
 
 // ── game status ───────────────────────────────────────────────────────────────
 
+// Shows the current position's analysis if it is cached, otherwise has it
+// computed on the thread pool; onAnalysisReady() comes back here.
 void MainWindow::updateGameStatus() {
-    PieceColor toMove = game.getCurrentTurn();
-    QString name = (toMove == PieceColor::White) ? "White" : "Black";
-    QString icon = (toMove == PieceColor::White) ? "♔" : "♚";
+    auto it = analysisCache.find(game.hash());
+    if (it != analysisCache.end()) {
+        showAnalysis(it->second);
+        return;
+    }
+    analysis = nullptr;
+    // One job at a time; a finished job re-enters here for the newest position.
+    if (analysisWatcher->isRunning()) return;
+    analysisWatcher->setFuture(QtConcurrent::run([position = game] {
+        return analyzePosition(position);
+    }));
+}
+
+void MainWindow::onAnalysisReady() {
+    PositionAnalysis result = analysisWatcher->result();
+    if (analysisCache.size() >= kAnalysisCacheSize) {
+        analysisCache.clear();
+        analysis = nullptr;   // pointed into the cache
+    }
+    analysisCache.emplace(result.hash, result);
+    updateGameStatus();
+}
 
-    if (game.isCheckmate(toMove)) {
-        QString winner = (toMove == PieceColor::White) ? "Black ♛" : "White ♕";
+const PositionAnalysis* MainWindow::currentAnalysis() const {
+    return analysis && analysis->hash == game.hash() ? analysis : nullptr;
+}
+
+void MainWindow::showAnalysis(const PositionAnalysis& a) {
+    analysis = &a;   // unordered_map never moves its elements
+    QString name = (a.toMove == PieceColor::White) ? "White" : "Black";
+    QString icon = (a.toMove == PieceColor::White) ? "♔" : "♚";
+
+    refreshBoard();   // repaint so king-check highlight appears immediately
+    if (a.checkmate) {
+        QString winner = (a.toMove == PieceColor::White) ? "Black ♛" : "White ♕";
         QMessageBox::information(this, "Game Over",
             QString("Checkmate!  %1 wins!").arg(winner));
         return;
     }
-    if (game.isStalemate(toMove)) {
+    if (a.stalemate) {
         QMessageBox::information(this, "Game Over",
             "Stalemate — the game is a draw!");
         return;
     }
-    if (game.isKingInCheck(toMove))
+    // Repetition and the move counters depend on the game's history, not
+    // just the position, so they are not part of the cached analysis.
+    switch (game.drawReason()) {
+    case ChessGame::DrawReason::Repetition:
+        QMessageBox::information(this, "Game Over", "Threefold repetition — the game is a draw!");
+        return;
+    case ChessGame::DrawReason::FiftyMoves:
+        QMessageBox::information(this, "Game Over",
+            "Fifty moves without a capture or pawn move — the game is a draw!");
+        return;
+    case ChessGame::DrawReason::InsufficientMaterial:
+        QMessageBox::information(this, "Game Over",
+            "Insufficient material — the game is a draw!");
+        return;
+    case ChessGame::DrawReason::None:
+        break;
+    }
+    if (a.inCheck)
         statusBar()->showMessage(QString("  %1  %2 is in CHECK!").arg(icon).arg(name));
+    else if (engineToMove())
+        statusBar()->showMessage(QString("  %1  %2 is thinking…").arg(icon).arg(name));
     else
         statusBar()->showMessage(QString("  %1  %2's turn").arg(icon).arg(name));
 
-    update();   // repaint so king-check highlight appears immediately
+    startEngine();
+}
+
+// ── computer player ───────────────────────────────────────────────────────────
+
+bool MainWindow::engineToMove() const {
+    return computerBlackAction && computerBlackAction->isChecked()
+        && game.getCurrentTurn() == PieceColor::Black;
+}
+
+// Searches a copy of the current position on the thread pool; the event
+// loop keeps running and onEngineMove() picks up the result. A drawn game
+// is over even though moves remain (mate and stalemate leave none).
+void MainWindow::startEngine() {
+    if (!engineToMove() || engineWatcher->isRunning()) return;
+    if (game.drawReason() != ChessGame::DrawReason::None) return;
+
+    searchedGeneration = engineGeneration;
+    SearchLimits limits;
+    limits.movetimeMs = kEngineMoveTimeMs;
+    searcher.prepare();   // before the worker starts, so stopEngine() always sticks
+    engineWatcher->setFuture(QtConcurrent::run([this, position = game, limits] {
+        return searcher.run(position, limits);
+    }));
+}
+
+// Makes the running search's result stale. startEngine() may already have
+// been refused while it unwinds; onEngineMove() then starts the next one.
+void MainWindow::stopEngine() {
+    ++engineGeneration;
+    searcher.stop();
+}
+
+void MainWindow::onEngineMove() {
+    SearchResult result = engineWatcher->result();
+    // A stopped search is cut short, and its position may no longer be
+    // shown: drop the move and search the current position if it is
+    // still the computer's turn.
+    if (searchedGeneration != engineGeneration) {
+        startEngine();
+        return;
+    }
+    if (!engineToMove() || result.bestMove == Move::none()) return;
+
+    playMove(result.bestMove);
+}
+
+// ── move history ──────────────────────────────────────────────────────────────
+
+void MainWindow::playMove(Move m) {
+    history.play(game, m);
+    positionChanged();
+}
+
+// Against the computer a take-back returns to the player's own turn.
+void MainWindow::takeBack() {
+    int ply = history.ply() - 1;
+    if (computerBlackAction->isChecked() && game.getCurrentTurn() == PieceColor::White && ply > 0)
+        --ply;   // Black's reply and White's move
+    jumpToPly(ply);
+}
+
+void MainWindow::stepForward() {
+    jumpToPly(history.ply() + 1);
+}
+
+void MainWindow::jumpToPly(int ply) {
+    if (ply < 0 || ply > history.length() || ply == history.ply()) return;
+    history.jumpTo(game, ply);
+    positionChanged();
+}
+
+void MainWindow::positionChanged() {
+    stopEngine();   // a running search is for a position no longer shown
+    selectedPos = Position(-1, -1);
+    validMoves.clear();
+    captureMoves.clear();
+    refreshBoard();
+    updateTimer->start(0);
 }
\ No newline at end of file
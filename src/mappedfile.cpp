@@ -0,0 +1,101 @@
+#include "mappedfile.h"
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+
+bool MappedFile::open(const string& path, Access access) {
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING,
+                              access == Access::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN
+                                                           : FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error_ = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        error_ = "cannot stat " + path;
+        return false;
+    }
+    if (size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void*  view    = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (mapping) CloseHandle(mapping);   // the view keeps the mapping alive
+        if (!view) {
+            CloseHandle(file);
+            error_ = "cannot map " + path;
+            return false;
+        }
+        data_ = static_cast<const char*>(view);
+        size_ = size_t(size.QuadPart);
+    }
+    CloseHandle(file);
+    open_ = true;
+    error_.clear();
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) UnmapViewOfFile(data_);
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+#else
+
+bool MappedFile::open(const string& path, Access access) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_ = path + ": " + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        error_ = path + ": " + strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size > 0) {
+        void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            error_ = path + ": " + strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        // Sequential: aggressive read-ahead and early reclaim of pages
+        // already passed. Random: no read-ahead beyond the touched page.
+        madvise(p, size_t(st.st_size), access == Access::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+        data_ = static_cast<const char*>(p);
+        size_ = size_t(st.st_size);
+    }
+    ::close(fd);   // the mapping outlives the descriptor
+    open_ = true;
+    error_.clear();
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+#endif
@@ -0,0 +1,535 @@
+#include "nnue.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// The SIMD kernels are compiled per function (target attributes), never for
+// the whole file, so the binary keeps running on CPUs without them.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NNUE_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace nnue {
+
+// ── file layout ───────────────────────────────────────────────────────────────
+namespace {
+
+const char kMagic[8] = { 'C', 'G', 'N', 'N', 'U', 'E', 0, 1 };
+
+struct Header {
+    char     magic[8];
+    uint32_t features, halfDims, hidden1, hidden2, outputDiv;
+    uint8_t  reserved[36];
+};
+static_assert(sizeof(Header) == 64, "network header is one cache line");
+
+struct Layout {
+    size_t ftBias, ftWeights, l1Bias, l1Weights, l2Bias, l2Weights, outBias, outWeights, size;
+};
+
+constexpr Layout makeLayout() {
+    Layout l{};
+    size_t at = sizeof(Header);
+    auto block = [&at](size_t bytes) {
+        size_t start = at;
+        at = (at + bytes + 63) & ~size_t(63);
+        return start;
+    };
+    l.ftBias     = block(kHalfDims * sizeof(int16_t));
+    l.ftWeights  = block(size_t(kFeatures) * kHalfDims * sizeof(int16_t));
+    l.l1Bias     = block(kHidden * sizeof(int32_t));
+    l.l1Weights  = block(kHidden * 2 * kHalfDims);
+    l.l2Bias     = block(kHidden * sizeof(int32_t));
+    l.l2Weights  = block(kHidden * kHidden);
+    l.outBias    = block(sizeof(int32_t));
+    l.outWeights = block(kHidden);
+    l.size       = at;
+    return l;
+}
+
+constexpr Layout kLayout = makeLayout();
+
+Header makeHeader() {
+    Header h{};
+    memcpy(h.magic, kMagic, sizeof kMagic);
+    h.features  = kFeatures;
+    h.halfDims  = kHalfDims;
+    h.hidden1   = kHidden;
+    h.hidden2   = kHidden;
+    h.outputDiv = kOutputDiv;
+    return h;
+}
+
+// Black sees the board flipped top to bottom, so both perspectives share
+// one set of weights. piece is a pieceIndex() other than a king.
+inline int featureIndex(PieceColor perspective, int kingSq, int piece, int sq) {
+    int  flip   = perspective == PieceColor::White ? 0 : 56;
+    bool theirs = piece / 6 != int(perspective);
+    return ((kingSq ^ flip) * 10 + (piece % 6) * 2 + theirs) * 64 + (sq ^ flip);
+}
+
+inline bool isKing(int piece) { return piece % 6 == int(PieceType::King) - 1; }
+
+inline uint8_t clipped(int v) { return uint8_t(min(max(v, 0), 127)); }
+
+} // namespace
+
+// The weights as the kernels see them.
+struct Layers {
+    explicit Layers(const Network& n)
+        : ftBias(n.ftBias_), ftWeights(n.ftWeights_), l1Bias(n.l1Bias_), l1Weights(n.l1Weights_),
+          l2Bias(n.l2Bias_), l2Weights(n.l2Weights_), outBias(n.outBias_), outWeights(n.outWeights_) {}
+
+    const int16_t* column(int feature) const { return ftWeights + size_t(feature) * kHalfDims; }
+
+    const int16_t* ftBias;
+    const int16_t* ftWeights;
+    const int32_t* l1Bias;
+    const int8_t*  l1Weights;
+    const int32_t* l2Bias;
+    const int8_t*  l2Weights;
+    const int32_t* outBias;
+    const int8_t*  outWeights;
+};
+
+// ── kernels ───────────────────────────────────────────────────────────────────
+// accumulate: out = in + the add columns - the sub columns, kHalfDims int16
+//             each, wrapping like the SIMD adds do.
+// propagate:  the dense layers on the two halves, side to move first; the
+//             raw network output.
+namespace {
+
+using Columns = const int16_t* const*;
+
+void accumulateScalar(const int16_t* in, int16_t* out, Columns add, int nAdd, Columns sub, int nSub) {
+    for (int i = 0; i < kHalfDims; ++i) {
+        int v = in[i];
+        for (int k = 0; k < nAdd; ++k) v += add[k][i];
+        for (int k = 0; k < nSub; ++k) v -= sub[k][i];
+        out[i] = int16_t(v);
+    }
+}
+
+// Hidden layers: kHidden outputs of n inputs each, weights row by row,
+// then the clipped ReLU. The SIMD versions produce four sums at a time, so
+// every input vector they load serves four rows.
+inline uint8_t activation(int32_t sum) { return clipped(sum >> 6); }
+
+int32_t dotScalar(const uint8_t* in, const int8_t* w, int n) {
+    int32_t sum = 0;
+    for (int j = 0; j < n; ++j) sum += int32_t(in[j]) * w[j];
+    return sum;
+}
+
+void affineScalar(const uint8_t* in, int n, const int32_t* bias, const int8_t* weights, uint8_t* out) {
+    for (int o = 0; o < kHidden; ++o) out[o] = activation(bias[o] + dotScalar(in, weights + o * n, n));
+}
+
+int32_t propagateScalar(const Layers& net, const int16_t* us, const int16_t* them) {
+    alignas(64) uint8_t input[2 * kHalfDims];
+    alignas(64) uint8_t h1[kHidden], h2[kHidden];
+    for (int i = 0; i < kHalfDims; ++i) {
+        input[i]             = clipped(us[i]);
+        input[kHalfDims + i] = clipped(them[i]);
+    }
+    affineScalar(input, 2 * kHalfDims, net.l1Bias, net.l1Weights, h1);
+    affineScalar(h1, kHidden, net.l2Bias, net.l2Weights, h2);
+    return net.outBias[0] + dotScalar(h2, net.outWeights, kHidden);
+}
+
+#ifdef NNUE_X86
+
+// SSE2: eight int16 per register, 64 accumulator entries per pass.
+__attribute__((target("sse2")))
+void accumulateSse2(const int16_t* in, int16_t* out, Columns add, int nAdd, Columns sub, int nSub) {
+    constexpr int kRegs = 8, kStep = kRegs * 8;
+    for (int c = 0; c < kHalfDims; c += kStep) {
+        __m128i r[kRegs];
+        for (int i = 0; i < kRegs; ++i) r[i] = _mm_load_si128((const __m128i*)(in + c) + i);
+        for (int k = 0; k < nAdd; ++k)
+            for (int i = 0; i < kRegs; ++i)
+                r[i] = _mm_add_epi16(r[i], _mm_loadu_si128((const __m128i*)(add[k] + c) + i));
+        for (int k = 0; k < nSub; ++k)
+            for (int i = 0; i < kRegs; ++i)
+                r[i] = _mm_sub_epi16(r[i], _mm_loadu_si128((const __m128i*)(sub[k] + c) + i));
+        for (int i = 0; i < kRegs; ++i) _mm_store_si128((__m128i*)(out + c) + i, r[i]);
+    }
+}
+
+// No byte multiply before SSSE3: the inputs are widened to int16 once per
+// 16 bytes, each row's weights by sign extension, and multiplied by madd.
+__attribute__((target("sse2")))
+inline __m128i madd8Sse2(__m128i xl, __m128i xh, const int8_t* w) {
+    __m128i y  = _mm_loadu_si128((const __m128i*)w);
+    __m128i yl = _mm_srai_epi16(_mm_unpacklo_epi8(y, y), 8);
+    __m128i yh = _mm_srai_epi16(_mm_unpackhi_epi8(y, y), 8);
+    return _mm_add_epi32(_mm_madd_epi16(xl, yl), _mm_madd_epi16(xh, yh));
+}
+
+__attribute__((target("sse2")))
+int32_t dotSse2(const uint8_t* in, const int8_t* w, int n) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = zero;
+    for (int j = 0; j < n; j += 16) {
+        __m128i x = _mm_load_si128((const __m128i*)(in + j));
+        sum = _mm_add_epi32(sum, madd8Sse2(_mm_unpacklo_epi8(x, zero), _mm_unpackhi_epi8(x, zero), w + j));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("sse2")))
+void affineSse2(const uint8_t* in, int n, const int32_t* bias, const int8_t* weights, uint8_t* out) {
+    const __m128i zero = _mm_setzero_si128();
+    for (int o = 0; o < kHidden; o += 4) {
+        const int8_t* w = weights + o * n;
+        __m128i s0 = zero, s1 = zero, s2 = zero, s3 = zero;
+        for (int j = 0; j < n; j += 16) {
+            __m128i x  = _mm_load_si128((const __m128i*)(in + j));
+            __m128i xl = _mm_unpacklo_epi8(x, zero), xh = _mm_unpackhi_epi8(x, zero);
+            s0 = _mm_add_epi32(s0, madd8Sse2(xl, xh, w + j));
+            s1 = _mm_add_epi32(s1, madd8Sse2(xl, xh, w + n + j));
+            s2 = _mm_add_epi32(s2, madd8Sse2(xl, xh, w + 2 * n + j));
+            s3 = _mm_add_epi32(s3, madd8Sse2(xl, xh, w + 3 * n + j));
+        }
+        // Transpose-and-add: lane k of the result is the total of sk.
+        __m128i a = _mm_add_epi32(_mm_unpacklo_epi32(s0, s1), _mm_unpackhi_epi32(s0, s1));
+        __m128i b = _mm_add_epi32(_mm_unpacklo_epi32(s2, s3), _mm_unpackhi_epi32(s2, s3));
+        __m128i t = _mm_add_epi32(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+        alignas(16) int32_t sums[4];
+        _mm_store_si128((__m128i*)sums, _mm_add_epi32(t, _mm_loadu_si128((const __m128i*)(bias + o))));
+        for (int k = 0; k < 4; ++k) out[o + k] = activation(sums[k]);
+    }
+}
+
+__attribute__((target("sse2")))
+void clipSse2(const int16_t* in, uint8_t* out) {
+    const __m128i lo = _mm_setzero_si128(), hi = _mm_set1_epi16(127);
+    for (int i = 0; i < kHalfDims; i += 16) {
+        __m128i a = _mm_min_epi16(_mm_max_epi16(_mm_load_si128((const __m128i*)(in + i)), lo), hi);
+        __m128i b = _mm_min_epi16(_mm_max_epi16(_mm_load_si128((const __m128i*)(in + i + 8)), lo), hi);
+        _mm_store_si128((__m128i*)(out + i), _mm_packus_epi16(a, b));
+    }
+}
+
+__attribute__((target("sse2")))
+int32_t propagateSse2(const Layers& net, const int16_t* us, const int16_t* them) {
+    alignas(64) uint8_t input[2 * kHalfDims];
+    alignas(64) uint8_t h1[kHidden], h2[kHidden];
+    clipSse2(us, input);
+    clipSse2(them, input + kHalfDims);
+    affineSse2(input, 2 * kHalfDims, net.l1Bias, net.l1Weights, h1);
+    affineSse2(h1, kHidden, net.l2Bias, net.l2Weights, h2);
+    return net.outBias[0] + dotSse2(h2, net.outWeights, kHidden);
+}
+
+// AVX2: sixteen int16 per register, 128 accumulator entries per pass.
+__attribute__((target("avx2")))
+void accumulateAvx2(const int16_t* in, int16_t* out, Columns add, int nAdd, Columns sub, int nSub) {
+    constexpr int kRegs = 8, kStep = kRegs * 16;
+    for (int c = 0; c < kHalfDims; c += kStep) {
+        __m256i r[kRegs];
+        for (int i = 0; i < kRegs; ++i) r[i] = _mm256_load_si256((const __m256i*)(in + c) + i);
+        for (int k = 0; k < nAdd; ++k)
+            for (int i = 0; i < kRegs; ++i)
+                r[i] = _mm256_add_epi16(r[i], _mm256_loadu_si256((const __m256i*)(add[k] + c) + i));
+        for (int k = 0; k < nSub; ++k)
+            for (int i = 0; i < kRegs; ++i)
+                r[i] = _mm256_sub_epi16(r[i], _mm256_loadu_si256((const __m256i*)(sub[k] + c) + i));
+        for (int i = 0; i < kRegs; ++i) _mm256_store_si256((__m256i*)(out + c) + i, r[i]);
+    }
+}
+
+// 32 byte products summed into eight int32. maddubs never saturates here:
+// inputs are at most 127, so a pair of products stays within +-32512.
+__attribute__((target("avx2")))
+inline __m256i madd8Avx2(__m256i x, const int8_t* w, __m256i ones) {
+    __m256i y = _mm256_loadu_si256((const __m256i*)w);
+    return _mm256_madd_epi16(_mm256_maddubs_epi16(x, y), ones);
+}
+
+__attribute__((target("avx2")))
+int32_t dotAvx2(const uint8_t* in, const int8_t* w, int n) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int j = 0; j < n; j += 32)
+        sum = _mm256_add_epi32(sum, madd8Avx2(_mm256_load_si256((const __m256i*)(in + j)), w + j, ones));
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+
+__attribute__((target("avx2")))
+void affineAvx2(const uint8_t* in, int n, const int32_t* bias, const int8_t* weights, uint8_t* out) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int o = 0; o < kHidden; o += 4) {
+        const int8_t* w = weights + o * n;
+        __m256i s0 = _mm256_setzero_si256(), s1 = s0, s2 = s0, s3 = s0;
+        for (int j = 0; j < n; j += 32) {
+            __m256i x = _mm256_load_si256((const __m256i*)(in + j));
+            s0 = _mm256_add_epi32(s0, madd8Avx2(x, w + j, ones));
+            s1 = _mm256_add_epi32(s1, madd8Avx2(x, w + n + j, ones));
+            s2 = _mm256_add_epi32(s2, madd8Avx2(x, w + 2 * n + j, ones));
+            s3 = _mm256_add_epi32(s3, madd8Avx2(x, w + 3 * n + j, ones));
+        }
+        // Two rounds of hadd leave each row's partial sums in lane k of
+        // both halves; adding the halves gives the four totals.
+        __m256i h = _mm256_hadd_epi32(_mm256_hadd_epi32(s0, s1), _mm256_hadd_epi32(s2, s3));
+        __m128i t = _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+        alignas(16) int32_t sums[4];
+        _mm_store_si128((__m128i*)sums, _mm_add_epi32(t, _mm_loadu_si128((const __m128i*)(bias + o))));
+        for (int k = 0; k < 4; ++k) out[o + k] = activation(sums[k]);
+    }
+}
+
+// packus works within 128-bit lanes; the permute puts the bytes back in order.
+__attribute__((target("avx2")))
+void clipAvx2(const int16_t* in, uint8_t* out) {
+    const __m256i lo = _mm256_setzero_si256(), hi = _mm256_set1_epi16(127);
+    for (int i = 0; i < kHalfDims; i += 32) {
+        __m256i a = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256((const __m256i*)(in + i)), lo), hi);
+        __m256i b = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256((const __m256i*)(in + i + 16)), lo), hi);
+        _mm256_store_si256((__m256i*)(out + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+    }
+}
+
+__attribute__((target("avx2")))
+int32_t propagateAvx2(const Layers& net, const int16_t* us, const int16_t* them) {
+    alignas(64) uint8_t input[2 * kHalfDims];
+    alignas(64) uint8_t h1[kHidden], h2[kHidden];
+    clipAvx2(us, input);
+    clipAvx2(them, input + kHalfDims);
+    affineAvx2(input, 2 * kHalfDims, net.l1Bias, net.l1Weights, h1);
+    affineAvx2(h1, kHidden, net.l2Bias, net.l2Weights, h2);
+    return net.outBias[0] + dotAvx2(h2, net.outWeights, kHidden);
+}
+
+#endif // NNUE_X86
+
+struct Kernels {
+    void    (*accumulate)(const int16_t* in, int16_t* out, Columns add, int nAdd, Columns sub, int nSub);
+    int32_t (*propagate)(const Layers& net, const int16_t* us, const int16_t* them);
+};
+
+// By Simd. Without x86 kernels bestSimd() is always Scalar.
+const Kernels kKernels[] = {
+    { accumulateScalar, propagateScalar },
+#ifdef NNUE_X86
+    { accumulateSse2,   propagateSse2   },
+    { accumulateAvx2,   propagateAvx2   },
+#else
+    { accumulateScalar, propagateScalar },
+    { accumulateScalar, propagateScalar },
+#endif
+};
+
+Simd detectSimd() {
+#ifdef NNUE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return Simd::Avx2;
+    if (__builtin_cpu_supports("sse2")) return Simd::Sse2;
+#endif
+    return Simd::Scalar;
+}
+
+Simd& current() {
+    static Simd s = bestSimd();
+    return s;
+}
+
+inline const Kernels& kernels() { return kKernels[int(current())]; }
+
+} // namespace
+
+Simd bestSimd() {
+    static const Simd best = detectSimd();
+    return best;
+}
+
+Simd simd() { return current(); }
+
+void setSimd(Simd s) { current() = min(s, bestSimd()); }
+
+const char* simdName(Simd s) {
+    switch (s) {
+    case Simd::Avx2: return "avx2";
+    case Simd::Sse2: return "sse2";
+    default:         return "scalar";
+    }
+}
+
+// ── network file ──────────────────────────────────────────────────────────────
+bool Network::load(const string& path) {
+    ftBias_ = ftWeights_ = nullptr;
+    l1Bias_ = l2Bias_ = outBias_ = nullptr;
+    l1Weights_ = l2Weights_ = outWeights_ = nullptr;
+    path_.clear();
+
+    if (!file_.open(path, MappedFile::Access::Random)) {
+        error_ = file_.error();
+        return false;
+    }
+    string_view data = file_.view();
+    Header header, expected = makeHeader();
+    if (data.size() < sizeof header) {
+        error_ = path + ": not a network file";
+    } else {
+        memcpy(&header, data.data(), sizeof header);
+        if (memcmp(header.magic, kMagic, sizeof kMagic) != 0)
+            error_ = path + ": not a network file";
+        else if (header.features != expected.features || header.halfDims != expected.halfDims ||
+                 header.hidden1 != expected.hidden1 || header.hidden2 != expected.hidden2 ||
+                 header.outputDiv != expected.outputDiv)
+            error_ = path + ": unsupported layer sizes";
+        else if (data.size() != kLayout.size)
+            error_ = path + ": truncated or oversized network";
+        else
+            error_.clear();
+    }
+    if (!error_.empty()) {
+        file_.close();
+        return false;
+    }
+
+    // The mapping is page aligned and every block starts on 64 bytes.
+    const char* base = data.data();
+    ftBias_     = reinterpret_cast<const int16_t*>(base + kLayout.ftBias);
+    ftWeights_  = reinterpret_cast<const int16_t*>(base + kLayout.ftWeights);
+    l1Bias_     = reinterpret_cast<const int32_t*>(base + kLayout.l1Bias);
+    l1Weights_  = reinterpret_cast<const int8_t*>(base + kLayout.l1Weights);
+    l2Bias_     = reinterpret_cast<const int32_t*>(base + kLayout.l2Bias);
+    l2Weights_  = reinterpret_cast<const int8_t*>(base + kLayout.l2Weights);
+    outBias_    = reinterpret_cast<const int32_t*>(base + kLayout.outBias);
+    outWeights_ = reinterpret_cast<const int8_t*>(base + kLayout.outWeights);
+    path_ = path;
+    return true;
+}
+
+// Scaled so activations land inside the clipping range rather than pinned
+// at either end of it.
+bool Network::writeRandom(const string& path, uint64_t seed, string* error) {
+    vector<char> buf(kLayout.size, 0);
+    auto next = [&seed](int lo, int hi) {   // splitmix64, uniform in [lo, hi]
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z ^= z >> 31;
+        return lo + int(z % uint64_t(hi - lo + 1));
+    };
+    auto fill16 = [&](size_t at, size_t n, int lo, int hi) {
+        for (size_t i = 0; i < n; ++i) {
+            int16_t v = int16_t(next(lo, hi));
+            memcpy(&buf[at + i * sizeof v], &v, sizeof v);
+        }
+    };
+    auto fill32 = [&](size_t at, size_t n, int lo, int hi) {
+        for (size_t i = 0; i < n; ++i) {
+            int32_t v = next(lo, hi);
+            memcpy(&buf[at + i * sizeof v], &v, sizeof v);
+        }
+    };
+    auto fill8 = [&](size_t at, size_t n, int lo, int hi) {
+        for (size_t i = 0; i < n; ++i) buf[at + i] = char(next(lo, hi));
+    };
+
+    Header header = makeHeader();
+    memcpy(buf.data(), &header, sizeof header);
+    fill16(kLayout.ftBias, kHalfDims, 0, 64);
+    fill16(kLayout.ftWeights, size_t(kFeatures) * kHalfDims, -20, 20);
+    fill32(kLayout.l1Bias, kHidden, -2048, 2048);
+    fill8(kLayout.l1Weights, size_t(kHidden) * 2 * kHalfDims, -8, 8);
+    fill32(kLayout.l2Bias, kHidden, -2048, 2048);
+    fill8(kLayout.l2Weights, size_t(kHidden) * kHidden, -32, 32);
+    fill32(kLayout.outBias, 1, -256, 256);
+    fill8(kLayout.outWeights, kHidden, -32, 32);
+
+    FILE* f = fopen(path.c_str(), "wb");
+    bool ok = f && fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+    if (f && fclose(f) != 0) ok = false;
+    if (!ok && error) *error = "cannot write " + path;
+    return ok;
+}
+
+// ── evaluation ────────────────────────────────────────────────────────────────
+void refresh(const Network& net, const BoardState& s, PieceColor perspective, Accumulator& acc) {
+    Layers layers(net);
+    int kingSq = lsb(s.of(perspective, PieceType::King));
+    const int16_t* add[32];
+    int count = 0;
+    for (int piece = 0; piece < 12; ++piece) {
+        if (isKing(piece)) continue;
+        for (Bitboard b = s.pieces[piece]; b; )
+            add[count++] = layers.column(featureIndex(perspective, kingSq, piece, popLsb(b)));
+    }
+    kernels().accumulate(layers.ftBias, acc.half[int(perspective)], add, count, nullptr, 0);
+}
+
+void update(const Network& net, const Accumulator& before, const BoardChanges& changes,
+            PieceColor perspective, int kingSq, Accumulator& after) {
+    Layers layers(net);
+    const int16_t* add[BoardChanges::kMax];
+    const int16_t* sub[BoardChanges::kMax];
+    int nAdd = 0, nSub = 0;
+    for (int i = 0; i < changes.count; ++i) {
+        int piece = changes.piece[i] & ~BoardChanges::kPutOn;
+        if (isKing(piece)) continue;
+        const int16_t* column = layers.column(featureIndex(perspective, kingSq, piece, changes.square[i]));
+        if (changes.piece[i] & BoardChanges::kPutOn) add[nAdd++] = column;
+        else                                         sub[nSub++] = column;
+    }
+    int p = int(perspective);
+    kernels().accumulate(before.half[p], after.half[p], add, nAdd, sub, nSub);
+}
+
+int propagate(const Network& net, const Accumulator& acc, PieceColor sideToMove) {
+    int us = int(sideToMove);
+    return kernels().propagate(Layers(net), acc.half[us], acc.half[us ^ 1]) / kOutputDiv;
+}
+
+int evaluate(const Network& net, const BoardState& s) {
+    Accumulator acc;
+    refresh(net, s, PieceColor::White, acc);
+    refresh(net, s, PieceColor::Black, acc);
+    return propagate(net, acc, s.sideToMove);
+}
+
+const Accumulator& AccumulatorStack::update(const Network& net, int ply, const BoardState& s) {
+    updateSide(net, ply, s, PieceColor::White);
+    updateSide(net, ply, s, PieceColor::Black);
+    return entries_[ply].acc;
+}
+
+// Walks back to the nearest ply holding this side's accumulator and replays
+// the changes from there, unless this side's king moved on the way.
+void AccumulatorStack::updateSide(const Network& net, int ply, const BoardState& s, PieceColor side) {
+    int c = int(side);
+    if (entries_[ply].computed[c]) return;
+    const uint8_t kingPutOn = uint8_t(pieceIndex(side, PieceType::King) | BoardChanges::kPutOn);
+    int from = ply;
+    for (; from > 0 && !entries_[from].computed[c]; --from) {
+        const BoardChanges& changes = entries_[from].changes;
+        if (find(changes.piece, changes.piece + changes.count, kingPutOn) != changes.piece + changes.count)
+            break;
+    }
+
+    if (!entries_[from].computed[c]) {
+        refresh(net, s, side, entries_[ply].acc);
+        ++refreshes;
+    } else {
+        int kingSq = lsb(s.of(side, PieceType::King));
+        for (int k = from + 1; k <= ply; ++k) {
+            nnue::update(net, entries_[k - 1].acc, entries_[k].changes, side, kingSq, entries_[k].acc);
+            entries_[k].computed[c] = true;
+            ++incremental;
+        }
+    }
+    entries_[ply].computed[c] = true;
+}
+
+} // namespace nnue
@@ -0,0 +1,249 @@
+#include "pgn.h"
+#include "san.h"
+#include <algorithm>
+
+using namespace std;
+
+static bool isBlank(char ch) { return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n'; }
+
+// Length of the termination marker starting text, or 0.
+static size_t resultLength(string_view text) {
+    for (string_view marker : { "1-0", "0-1", "1/2-1/2", "*" })
+        if (text.substr(0, marker.size()) == marker &&
+            (text.size() == marker.size() || isBlank(text[marker.size()])))
+            return marker.size();
+    return 0;
+}
+
+// [Name "value"] — anything else on a tag line is ignored.
+static void parseTag(string_view line, vector<PgnTag>& tags) {
+    size_t i = 1;
+    while (i < line.size() && line[i] == ' ') ++i;
+    size_t nameStart = i;
+    while (i < line.size() && !isBlank(line[i]) && line[i] != '"' && line[i] != ']') ++i;
+    string_view name = line.substr(nameStart, i - nameStart);
+    while (i < line.size() && line[i] == ' ') ++i;
+    if (name.empty() || i >= line.size() || line[i] != '"') return;
+    size_t valueStart = ++i;
+    while (i < line.size() && line[i] != '"') i += line[i] == '\\' ? 2 : 1;
+    if (i >= line.size()) return;
+    tags.push_back({ name, line.substr(valueStart, i - valueStart) });
+}
+
+string_view PgnGame::tag(string_view name) const {
+    for (const PgnTag& t : tags)
+        if (t.name == name) return t.value;
+    return {};
+}
+
+// Whitespace and "%" escape lines between games.
+void PgnReader::skipBlank() {
+    while (pos_ < text_.size()) {
+        char ch = text_[pos_];
+        if (ch == '\n') {
+            ++line_;
+            ++pos_;
+        } else if (isBlank(ch)) {
+            ++pos_;
+        } else if (ch == '%' && (pos_ == 0 || text_[pos_ - 1] == '\n')) {
+            pos_ = min(text_.find('\n', pos_), text_.size());
+        } else {
+            break;
+        }
+    }
+}
+
+bool PgnReader::next(PgnGame& game) {
+    game.tags.clear();
+    game.movetext = {};
+    skipBlank();
+    if (pos_ >= text_.size()) return false;
+
+    game.offset = pos_;
+    game.line   = line_;
+    while (pos_ < text_.size() && text_[pos_] == '[') {
+        size_t eol = min(text_.find('\n', pos_), text_.size());
+        parseTag(text_.substr(pos_, eol - pos_), game.tags);
+        pos_ = eol;
+        skipBlank();
+    }
+
+    game.movetextLine = line_;
+    size_t start = pos_;
+    while (pos_ < text_.size()) {
+        char ch = text_[pos_];
+        if (ch == '\n') {
+            ++line_;
+            ++pos_;
+        } else if (ch == '{') {
+            size_t close = min(text_.find('}', pos_), text_.size());
+            for (size_t i = pos_; i < close; ++i) line_ += text_[i] == '\n';
+            pos_ = min(close + 1, text_.size());
+        } else if (ch == ';') {
+            pos_ = min(text_.find('\n', pos_), text_.size());
+        } else if (ch == '[' && pos_ > 0 && text_[pos_ - 1] == '\n') {
+            break;   // the next game's tags; this one had no result
+        } else if ((ch == '1' || ch == '0' || ch == '*') && (pos_ == start || isBlank(text_[pos_ - 1]))) {
+            size_t n = resultLength(text_.substr(pos_));
+            pos_ += n ? n : 1;
+            if (n) break;
+        } else {
+            ++pos_;
+        }
+    }
+    game.movetext = text_.substr(start, pos_ - start);
+    return true;
+}
+
+vector<PgnChunk> splitPgn(string_view text, size_t chunkBytes) {
+    vector<PgnChunk> chunks;
+    size_t   start = 0;
+    unsigned line  = 1;
+    while (start < text.size()) {
+        size_t end = text.size();
+        for (size_t pos = start + max<size_t>(chunkBytes, 1); pos < text.size(); ++pos) {
+            pos = text.find("\n[", pos);
+            if (pos == string_view::npos) break;
+            // Blank line (possibly with a CR) right before the tag line.
+            size_t prev = text.rfind('\n', pos - 1);
+            if (prev != string_view::npos && prev >= start &&
+                text.substr(prev + 1, pos - prev - 1).find_first_not_of(" \t\r") == string_view::npos) {
+                end = pos + 1;
+                break;
+            }
+        }
+        string_view chunk = text.substr(start, end - start);
+        chunks.push_back({ chunk, line });
+        line  += unsigned(count(chunk.begin(), chunk.end(), '\n'));
+        start  = end;
+    }
+    return chunks;
+}
+
+static bool fail(PgnReplay& out, unsigned line, string message) {
+    out.errorLine = line;
+    out.error     = move(message);
+    return false;
+}
+
+bool replayPgn(const PgnGame& pgn, ChessGame& game, PgnReplay& out, vector<Move>* moves) {
+    out = PgnReplay();
+    string_view fen = pgn.tag("FEN");
+    if (fen.empty()) {
+        game.initializeBoard();
+    } else if (!game.fromFEN(fen)) {
+        return fail(out, pgn.line, "invalid FEN tag \"" + string(fen) + "\"");
+    }
+
+    string_view text = pgn.movetext;
+    unsigned line = pgn.movetextLine;
+    int variation = 0;   // nesting depth of ( ... )
+    size_t i = 0;
+    while (i < text.size()) {
+        char ch = text[i];
+        if (ch == '\n') { ++line; ++i; continue; }
+        if (isBlank(ch)) { ++i; continue; }
+        if (ch == '{') {
+            size_t close = text.find('}', i);
+            if (close == string_view::npos) return fail(out, line, "unterminated comment");
+            for (; i < close; ++i) line += text[i] == '\n';
+            i = close + 1;
+            continue;
+        }
+        if (ch == ';') { i = min(text.find('\n', i), text.size()); continue; }
+        if (ch == '(') { ++variation; ++i; continue; }
+        if (ch == ')') {
+            if (variation == 0) return fail(out, line, "unbalanced ')'");
+            --variation;
+            ++i;
+            continue;
+        }
+
+        size_t start = i;
+        while (i < text.size() && !isBlank(text[i]) && text[i] != '{' && text[i] != '}' &&
+               text[i] != '(' && text[i] != ')' && text[i] != ';')
+            ++i;
+        string_view token = text.substr(start, i - start);
+        if (variation > 0 || token[0] == '$') continue;   // side lines and NAGs
+        if (resultLength(token) == token.size()) {
+            out.result = token;
+            break;
+        }
+
+        // Move numbers, also when glued to the move: "12.", "12...", "12.Nf3".
+        size_t digits = 0;
+        while (digits < token.size() && token[digits] >= '0' && token[digits] <= '9') ++digits;
+        if (digits && digits < token.size() && token[digits] == '.') {
+            while (digits < token.size() && token[digits] == '.') ++digits;
+            token.remove_prefix(digits);
+        }
+        if (token.empty() || token == "e.p." || token.find_first_not_of("!?") == string_view::npos)
+            continue;
+
+        Move m = san::parse(game, token);
+        if (m == Move::none())
+            return fail(out, line, "illegal or ambiguous move \"" + string(token) + "\" at ply " +
+                                   to_string(out.plies + 1));
+        MoveUndo undo;
+        game.makeMove(m, undo);
+        ++out.plies;
+        if (moves) moves->push_back(m);
+    }
+    if (variation > 0) return fail(out, line, "unterminated variation");
+    return true;
+}
+
+bool formatPgn(const vector<PgnTag>& tags, const vector<Move>& moves, string& out) {
+    ChessGame game;
+    string_view fen = {}, result = "*";
+    for (const PgnTag& t : tags) {
+        if (t.name == "FEN")    fen = t.value;
+        if (t.name == "Result") result = t.value;
+    }
+    if (!fen.empty() && !game.fromFEN(fen)) return false;
+
+    string text;
+    for (const PgnTag& t : tags) {
+        text += '[';
+        text += t.name;
+        text += " \"";
+        text += t.value;
+        text += "\"]\n";
+    }
+    text += '\n';
+
+    size_t lineStart = text.size();
+    auto append = [&](const string& token) {
+        if (text.size() > lineStart && text.size() - lineStart + 1 + token.size() >= 80) {
+            text += '\n';
+            lineStart = text.size();
+        } else if (text.size() > lineStart) {
+            text += ' ';
+        }
+        text += token;
+    };
+
+    bool first = true;
+    for (Move m : moves) {
+        MoveList legal;
+        game.generateLegalMoves(legal);
+        if (find(legal.begin(), legal.end(), m) == legal.end()) return false;
+
+        const BoardState& s = game.state();
+        string token;
+        if (s.sideToMove == PieceColor::White)
+            token = to_string(s.fullmoveNumber) + ". ";
+        else if (first)
+            token = to_string(s.fullmoveNumber) + "... ";
+        token += san::format(game, m);
+        append(token);
+        first = false;
+
+        MoveUndo undo;
+        game.makeMove(m, undo);
+    }
+    append(string(result));
+    text += "\n\n";
+    out += text;
+    return true;
+}
@@ -0,0 +1,136 @@
+#include "san.h"
+
+using namespace std;
+
+namespace san {
+
+static PieceType pieceFromLetter(char ch) {
+    switch (ch) {
+    case 'N': return PieceType::Knight;
+    case 'B': return PieceType::Bishop;
+    case 'R': return PieceType::Rook;
+    case 'Q': return PieceType::Queen;
+    case 'K': return PieceType::King;
+    default:  return PieceType::None;
+    }
+}
+
+static char letterOf(PieceType t) {
+    static const char kLetters[] = " PRNBQK";   // by PieceType
+    return kLetters[int(t)];
+}
+
+static bool endsWith(string_view s, string_view suffix) {
+    return s.size() >= suffix.size() && s.substr(s.size() - suffix.size()) == suffix;
+}
+
+Move parse(const ChessGame& game, string_view text) {
+    // Markers that carry no information about which move was played.
+    if (endsWith(text, "e.p.")) text.remove_suffix(4);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '+' || text.back() == '#' ||
+                             text.back() == '!' || text.back() == '?'))
+        text.remove_suffix(1);
+    if (text.size() < 2) return Move::none();
+
+    MoveList moves;
+    game.generateLegalMoves(moves);
+
+    if (text == "O-O" || text == "0-0" || text == "O-O-O" || text == "0-0-0") {
+        int flag = text.size() == 3 ? KingCastle : QueenCastle;
+        for (Move m : moves)
+            if (m.flags() == flag) return m;
+        return Move::none();
+    }
+
+    PieceType piece = pieceFromLetter(text[0]);
+    if (piece != PieceType::None) text.remove_prefix(1);
+    else                          piece = PieceType::Pawn;
+
+    // "e8=Q" or "e8Q"
+    PieceType promo = PieceType::None;
+    if (piece == PieceType::Pawn) {
+        PieceType p = pieceFromLetter(text.back());
+        if (p != PieceType::None && p != PieceType::King) {
+            promo = p;
+            text.remove_suffix(1);
+            if (!text.empty() && text.back() == '=') text.remove_suffix(1);
+        }
+    }
+
+    if (text.size() < 2) return Move::none();
+    char file = text[text.size() - 2], rank = text[text.size() - 1];
+    if (file < 'a' || file > 'h' || rank < '1' || rank > '8') return Move::none();
+    int to = (rank - '1') * 8 + (file - 'a');
+    text.remove_suffix(2);
+
+    // What is left disambiguates: a file, a rank, or both, plus an optional
+    // capture or long-notation separator.
+    int fromFile = -1, fromRank = -1;
+    for (char ch : text) {
+        if      (ch >= 'a' && ch <= 'h') fromFile = ch - 'a';
+        else if (ch >= '1' && ch <= '8') fromRank = ch - '1';
+        else if (ch != 'x' && ch != ':' && ch != '-') return Move::none();
+    }
+
+    const BoardState& s = game.state();
+    Bitboard ours = s.of(s.sideToMove, piece);
+    Move found = Move::none();
+    int  matches = 0;
+    for (Move m : moves) {
+        if (m.to() != to || !(ours & bit(m.from())) || m.promotion() != promo) continue;
+        if (fromFile >= 0 && (m.from() & 7) != fromFile) continue;
+        if (fromRank >= 0 && (m.from() >> 3) != fromRank) continue;
+        found = m;
+        ++matches;
+    }
+    return matches == 1 ? found : Move::none();
+}
+
+string format(ChessGame& game, Move move) {
+    string out;
+    if (move.isCastle()) {
+        out = move.flags() == KingCastle ? "O-O" : "O-O-O";
+    } else {
+        const BoardState& s = game.state();
+        PieceType piece = s.typeAt(move.from());
+        int fromFile = move.from() & 7, fromRank = move.from() >> 3;
+        if (piece == PieceType::Pawn) {
+            if (move.isCapture()) out += char('a' + fromFile);
+        } else {
+            out += letterOf(piece);
+            // Another piece of the same kind reaching the same square: name
+            // the file if that tells them apart, else the rank, else both.
+            MoveList moves;
+            game.generateLegalMoves(moves);
+            bool clash = false, sameFile = false, sameRank = false;
+            for (Move m : moves) {
+                if (m.to() != move.to() || m.from() == move.from() || s.typeAt(m.from()) != piece)
+                    continue;
+                clash = true;
+                sameFile |= (m.from() & 7) == fromFile;
+                sameRank |= (m.from() >> 3) == fromRank;
+            }
+            if (clash) {
+                if (!sameFile)      out += char('a' + fromFile);
+                else if (!sameRank) out += char('1' + fromRank);
+                else { out += char('a' + fromFile); out += char('1' + fromRank); }
+            }
+        }
+        if (move.isCapture()) out += 'x';
+        out += char('a' + (move.to() & 7));
+        out += char('1' + (move.to() >> 3));
+        if (move.isPromotion()) {
+            out += '=';
+            out += letterOf(move.promotion());
+        }
+    }
+
+    MoveUndo undo;
+    game.makeMove(move, undo);
+    PieceColor them = game.getCurrentTurn();
+    if (game.isKingInCheck(them)) out += game.isCheckmate(them) ? '#' : '+';
+    game.unmakeMove(undo);
+    return out;
+}
+
+} // namespace san
@@ -0,0 +1,368 @@
+#include "search.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+// Move ordering values, indexed by PieceType (None, Pawn, Rook, Knight,
+// Bishop, Queen, King). The evaluation has its own, in eval.h.
+constexpr int kPieceValue[] = { 0, 100, 500, 320, 330, 900, 0 };
+
+using Clock = chrono::steady_clock;
+
+int64_t nowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// Ordering bands: the hash / PV move, then captures and promotions, then
+// killers, then quiets by history (which stays below kKillerScore).
+constexpr int kHashScore    = 1 << 30;
+constexpr int kCaptureScore = 1 << 28;
+constexpr int kKillerScore  = 1 << 26;
+
+// Mate scores are stored relative to the node, not the root.
+int toTT(int score, int ply) {
+    return score >= kMateScore - kMaxPly ? score + ply : score <= -kMateScore + kMaxPly ? score - ply : score;
+}
+int fromTT(int score, int ply) {
+    return score >= kMateScore - kMaxPly ? score - ply : score <= -kMateScore + kMaxPly ? score + ply : score;
+}
+
+} // namespace
+
+int evaluate(const ChessGame& game) {
+    return eval::score(game.evalTerms(), game.getCurrentTurn());
+}
+
+static_assert(nnue::AccumulatorStack::kPlies > kMaxPly, "an accumulator for every ply");
+
+void Searcher::setNetwork(const nnue::Network* net) {
+    net_ = net && net->isLoaded() ? net : nullptr;
+    if (net_ && !accumulators_) accumulators_ = make_unique<nnue::AccumulatorStack>();
+}
+
+// A network's output is kept clear of the mate range. Debug builds
+// (CHESS_VERIFY_NNUE) check the incremental accumulators against a
+// from-scratch evaluation at every node.
+int Searcher::staticEval(const ChessGame& game, int ply) {
+    if (!net_) return evaluate(game);
+    int score = accumulators_->evaluate(*net_, ply, game.state());
+#ifdef CHESS_VERIFY_NNUE
+    assert(score == nnue::evaluate(*net_, game.state()) && "incremental NNUE accumulator diverged");
+#endif
+    return clamp(score, -kMateScore + kMaxPly + 1, kMateScore - kMaxPly - 1);
+}
+
+void Searcher::makeMove(ChessGame& game, Move m, MoveUndo& undo, int ply) {
+    game.makeMove(m, undo);
+    if (net_) accumulators_->push(ply + 1, undo.changes);
+}
+
+void Searcher::prepare() {
+    stopRequested_.store(false, memory_order_relaxed);
+    nodes_.store(0, memory_order_relaxed);
+}
+
+SearchResult Searcher::run(const ChessGame& root, const SearchLimits& limits,
+                           const Progress& onIteration) {
+    stopped_ = false;
+    nodes_.store(0, memory_order_relaxed);
+    if (tt_) tt_->newSearch();
+    return iterate(root, limits, onIteration, 1);
+}
+
+SearchResult Searcher::iterate(const ChessGame& root, const SearchLimits& limits,
+                               const Progress& onIteration, int firstDepth) {
+    limits_     = limits;
+    deadlineNs_ = limits.movetimeMs > 0 ? nowNs() + int64_t(limits.movetimeMs) * 1000000 : 0;
+    memset(history_, 0, sizeof history_);
+    for (auto& k : killers_) k[0] = k[1] = Move::none();
+    prevPvLength_ = 0;
+    ttStats_      = TTStats();
+
+    ChessGame game(root);
+    if (net_) accumulators_->reset();
+    SearchResult result;
+    int64_t t0 = nowNs();
+
+    MoveList rootMoves;
+    game.generateLegalMoves(rootMoves);
+    if (rootMoves.empty()) {
+        result.score = game.isKingInCheck(game.getCurrentTurn()) ? -kMateScore : 0;
+        return result;
+    }
+
+    int maxDepth = min(max(limits.depth, 1), kMaxPly - 1);
+    for (int depth = min(firstDepth, maxDepth); depth <= maxDepth; ++depth) {
+        rootDepth_ = depth;
+        int score  = search(game, depth, 0, -kInfinity, kInfinity);
+
+        // An interrupted iteration is thrown away, unless it is the first
+        // and has at least one fully searched root move to offer; the score
+        // is then the best of those moves.
+        if (stopped_ && (result.depth > 0 || pvLength_[0] == 0))
+            break;
+
+        result.score = score;
+        result.depth = depth;
+        result.pv.assign(pv_[0], pv_[0] + pvLength_[0]);
+        result.bestMove = result.pv.front();
+        copy(result.pv.begin(), result.pv.end(), prevPv_);
+        prevPvLength_   = int(result.pv.size());
+        result.nodes    = nodes();
+        result.seconds  = (nowNs() - t0) / 1e9;
+        result.nps      = result.seconds > 0 ? uint64_t(nodes() / result.seconds) : 0;
+        result.tt       = ttStats_;
+        result.hashfull = tt_ ? tt_->hashfull() : 0;
+        if (onIteration) onIteration(result);
+
+        if (stopped_) break;
+        // A forced mate within the horizon will not get any shorter.
+        if (isMateScore(score) && kMateScore - abs(score) <= depth) break;
+    }
+
+    if (result.bestMove == Move::none()) result.bestMove = rootMoves[0];
+    result.nodes   = nodes();
+    result.seconds = (nowNs() - t0) / 1e9;
+    result.nps     = result.seconds > 0 ? uint64_t(nodes() / result.seconds) : 0;
+    result.tt      = ttStats_;
+    result.hashfull = tt_ ? tt_->hashfull() : 0;
+    return result;
+}
+
+// Polled on every node; the clock is only read every 1024 nodes. Until
+// the first root move of depth 1 has been searched (and given the root a
+// line), neither limits nor stop requests apply, so there is always a
+// searched move and score to report however slow the evaluation is.
+bool Searcher::outOfBudget() {
+    if (stopped_) return true;
+    if (rootDepth_ == 1 && pvLength_[0] == 0) return false;
+    uint64_t n = nodes();
+    if (stopRequested_.load(memory_order_relaxed) ||
+        (limits_.nodes && n >= limits_.nodes) ||
+        (deadlineNs_ && (n & 1023) == 0 && nowNs() >= deadlineNs_)) {
+        stopped_ = true;
+        return true;
+    }
+    return false;
+}
+
+void Searcher::orderMoves(const ChessGame& game, MoveList& moves, int ply, Move hashMove) const {
+    const BoardState& s = game.state();
+    int us = int(s.sideToMove);
+    int scores[256];
+
+    for (int i = 0; i < moves.size(); ++i) {
+        Move m = moves[i];
+        int score;
+        if (m == hashMove) {
+            score = kHashScore;
+        } else if (m.isCapture() || m.isPromotion()) {
+            // MVV-LVA: most valuable victim first, cheapest attacker breaks ties.
+            int victim   = m.isEnPassant() ? kPieceValue[int(PieceType::Pawn)]
+                         : m.isCapture()   ? kPieceValue[int(s.typeAt(m.to()))] : 0;
+            int attacker = kPieceValue[int(s.typeAt(m.from()))];
+            score = kCaptureScore + (victim + kPieceValue[int(m.promotion())]) * 16 - attacker / 16;
+        } else if (m == killers_[ply][0]) {
+            score = kKillerScore + 1;
+        } else if (m == killers_[ply][1]) {
+            score = kKillerScore;
+        } else {
+            score = history_[us][m.from()][m.to()];
+        }
+        scores[i] = score;
+    }
+
+    // Insertion sort, best first: lists are short and often nearly ordered.
+    for (int i = 1; i < moves.size(); ++i) {
+        Move m = moves[i];
+        int  sc = scores[i], j = i - 1;
+        for (; j >= 0 && scores[j] < sc; --j) {
+            moves[j + 1]  = moves[j];
+            scores[j + 1] = scores[j];
+        }
+        moves[j + 1]  = m;
+        scores[j + 1] = sc;
+    }
+}
+
+int Searcher::search(ChessGame& game, int depth, int ply, int alpha, int beta) {
+    if (depth <= 0) return quiesce(game, ply, alpha, beta);
+
+    pvLength_[ply] = 0;
+    countNode();
+    if (outOfBudget()) return 0;
+    if (ply >= kMaxPly - 1) return staticEval(game, ply);
+    // A repetition inside the search is scored as a draw right away: if it
+    // was good for either side, the third occurrence would follow.
+    if (ply > 0 && (game.repetitions(1) || game.isFiftyMoveDraw() || game.isInsufficientMaterial()))
+        return 0;
+
+    // The root always searches, so there is a move to report.
+    TTHit hit;
+    Move  hashMove = Move::none();
+    if (tt_ && tt_->probe(game.hash(), hit, ttStats_)) {
+        hashMove  = hit.move;
+        int score = fromTT(hit.score, ply);
+        if (ply > 0 && hit.depth >= depth &&
+            (hit.bound == Bound::Exact ||
+             (hit.bound == Bound::Lower && score >= beta) ||
+             (hit.bound == Bound::Upper && score <= alpha)))
+            return score;
+    }
+
+    MoveList moves;
+    game.generateLegalMoves(moves);
+    if (moves.empty())
+        return game.isKingInCheck(game.getCurrentTurn()) ? -kMateScore + ply : 0;
+
+    // Without a hash move, the previous iteration's line is tried first
+    // wherever it applies.
+    if (hashMove == Move::none() && ply < prevPvLength_) hashMove = prevPv_[ply];
+    orderMoves(game, moves, ply, hashMove);
+
+    int  alphaOrig = alpha;
+    int  best      = -kInfinity;
+    Move bestMove  = Move::none();
+    for (Move m : moves) {
+        MoveUndo undo;
+        makeMove(game, m, undo, ply);
+        int score = -search(game, depth - 1, ply + 1, -beta, -alpha);
+        game.unmakeMove(undo);
+        // The root keeps what its finished moves found; iterate() decides
+        // whether to use it.
+        if (stopped_) return ply == 0 ? best : 0;
+
+        if (score <= best) continue;
+        best = score;
+        if (score <= alpha) continue;
+        alpha    = score;
+        bestMove = m;
+
+        pv_[ply][0] = m;
+        memcpy(&pv_[ply][1], pv_[ply + 1], pvLength_[ply + 1] * sizeof(Move));
+        pvLength_[ply] = pvLength_[ply + 1] + 1;
+
+        if (alpha >= beta) {
+            if (!m.isCapture() && !m.isPromotion()) {
+                if (m != killers_[ply][0]) {
+                    killers_[ply][1] = killers_[ply][0];
+                    killers_[ply][0] = m;
+                }
+                int& h = history_[int(game.getCurrentTurn())][m.from()][m.to()];
+                h = min(h + depth * depth, kKillerScore - 1);
+            }
+            break;
+        }
+    }
+
+    if (tt_) {
+        Bound bound = best >= beta ? Bound::Lower : best > alphaOrig ? Bound::Exact : Bound::Upper;
+        tt_->store(game.hash(), bestMove, toTT(best, ply), depth, bound);
+    }
+    return best;
+}
+
+// Captures only, with the static evaluation as a stand-pat lower bound.
+int Searcher::quiesce(ChessGame& game, int ply, int alpha, int beta) {
+    pvLength_[ply] = 0;
+    countNode();
+    if (outOfBudget()) return 0;
+
+    int standPat = staticEval(game, ply);
+    if (standPat >= beta || ply >= kMaxPly - 1) return standPat;
+    alpha = max(alpha, standPat);
+
+    MoveList moves;
+    game.generateCaptures(moves);
+    orderMoves(game, moves, ply, Move::none());
+
+    int best = standPat;
+    for (Move m : moves) {
+        MoveUndo undo;
+        makeMove(game, m, undo, ply);
+        int score = -quiesce(game, ply + 1, -beta, -alpha);
+        game.unmakeMove(undo);
+        if (stopped_) return 0;
+
+        if (score <= best) continue;
+        best = score;
+        if (score > alpha) alpha = score;
+        if (alpha >= beta) break;
+    }
+    return best;
+}
+
+ParallelSearcher::ParallelSearcher(TranspositionTable& tt, int threads) : tt_(tt) {
+    setThreads(threads);
+}
+
+void ParallelSearcher::setThreads(int threads) {
+    searchers_.clear();
+    for (int i = 0; i < max(threads, 1); ++i) {
+        searchers_.push_back(make_unique<Searcher>(&tt_));
+        searchers_.back()->setNetwork(net_);
+    }
+}
+
+void ParallelSearcher::setNetwork(const nnue::Network* net) {
+    net_ = net;
+    for (auto& s : searchers_) s->setNetwork(net);
+}
+
+void ParallelSearcher::prepare() {
+    for (auto& s : searchers_) s->prepare();
+}
+
+void ParallelSearcher::stop() {
+    for (auto& s : searchers_) s->stop();
+}
+
+SearchResult ParallelSearcher::run(const ChessGame& root, const SearchLimits& limits,
+                                   const Searcher::Progress& onIteration) {
+    // Only the main thread's stop request is the caller's. The helpers'
+    // are left over from the last run and are cleared here; the main
+    // thread passes a new one on when it stops.
+    for (auto& s : searchers_) {
+        if (s != searchers_[0]) s->stopRequested_.store(false, memory_order_relaxed);
+        s->stopped_ = false;
+        s->nodes_.store(0, memory_order_relaxed);
+    }
+    tt_.newSearch();
+
+    // Helpers have no limits of their own: they stop when the main thread does.
+    SearchLimits helperLimits;
+    vector<thread> helpers;
+    for (size_t i = 1; i < searchers_.size(); ++i)
+        helpers.emplace_back([&, i] {
+            searchers_[i]->iterate(root, helperLimits, nullptr, 1 + int(i & 1));
+        });
+
+    auto totalNodes = [&] {
+        uint64_t n = 0;
+        for (auto& s : searchers_) n += s->nodes();
+        return n;
+    };
+    auto withTotals = [&](SearchResult r) {
+        r.nodes = totalNodes();
+        r.nps   = r.seconds > 0 ? uint64_t(r.nodes / r.seconds) : 0;
+        return r;
+    };
+
+    Searcher::Progress progress;
+    if (onIteration)
+        progress = [&](const SearchResult& r) { onIteration(withTotals(r)); };
+    SearchResult result = searchers_[0]->iterate(root, limits, progress, 1);
+
+    for (size_t i = 1; i < searchers_.size(); ++i) searchers_[i]->stop();
+    for (auto& t : helpers) t.join();
+
+    result = withTotals(result);
+    for (size_t i = 1; i < searchers_.size(); ++i) result.tt += searchers_[i]->ttStats_;
+    return result;
+}
@@ -0,0 +1,76 @@
+#include "threadpool.h"
+#include <algorithm>
+
+using namespace std;
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads <= 0) threads = max(1, int(thread::hardware_concurrency()));
+    queues_ = make_unique<Queue[]>(size_t(threads));
+    for (int i = 0; i < threads; ++i)
+        workers_.emplace_back([this, i] { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        quit_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : workers_) t.join();
+}
+
+void ThreadPool::run(size_t count, const function<void(size_t, int)>& task) {
+    if (count == 0) return;
+    unique_lock<mutex> lock(mutex_);
+    // A worker that woke too late for the previous batch may still be
+    // looking at the queues with that batch's task; let it leave first.
+    done_.wait(lock, [this] { return active_ == 0; });
+
+    size_t n = workers_.size();
+    for (size_t w = 0; w < n; ++w) {
+        lock_guard<mutex> queueLock(queues_[w].mutex);
+        for (size_t i = count * w / n; i < count * (w + 1) / n; ++i) queues_[w].items.push_back(i);
+    }
+    task_ = &task;
+    remaining_.store(count, memory_order_relaxed);
+    ++batch_;
+    wake_.notify_all();
+    done_.wait(lock, [this] { return remaining_.load(memory_order_acquire) == 0 && active_ == 0; });
+    task_ = nullptr;
+}
+
+// Own queue from the front, then everyone else's from the back.
+bool ThreadPool::take(int id, size_t& index) {
+    int n = size();
+    for (int k = 0; k < n; ++k) {
+        Queue& q = queues_[(id + k) % n];
+        lock_guard<mutex> lock(q.mutex);
+        if (q.items.empty()) continue;
+        if (k == 0) { index = q.items.front(); q.items.pop_front(); }
+        else        { index = q.items.back();  q.items.pop_back();  }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(int id) {
+    unsigned seen = 0;
+    for (;;) {
+        const function<void(size_t, int)>* task;
+        {
+            unique_lock<mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return quit_ || batch_ != seen; });
+            if (quit_) return;
+            seen = batch_;
+            task = task_;
+            ++active_;
+        }
+        size_t index;
+        while (take(id, index)) {
+            (*task)(index, id);
+            remaining_.fetch_sub(1, memory_order_acq_rel);
+        }
+        lock_guard<mutex> lock(mutex_);
+        if (--active_ == 0) done_.notify_all();
+    }
+}
@@ -0,0 +1,34 @@
+#include "transposition.h"
+#include <algorithm>
+
+using namespace std;
+
+void TranspositionTable::resize(size_t megabytes) {
+    size_t count = max<size_t>(megabytes, 1) * (1 << 20) / sizeof(Bucket);
+    size_t pow2  = 1;
+    while (pow2 * 2 <= count) pow2 *= 2;
+    buckets_.reset(new Bucket[pow2]);
+    mask_       = pow2 - 1;
+    generation_ = 0;
+}
+
+void TranspositionTable::clear() {
+    for (uint64_t i = 0; i <= mask_; ++i)
+        for (Entry& e : buckets_[i].entries) {
+            e.check.store(0, memory_order_relaxed);
+            e.data.store(0, memory_order_relaxed);
+        }
+    generation_ = 0;
+}
+
+// Samples the first 500 buckets (1000 entries), as UCI's "hashfull" expects.
+int TranspositionTable::hashfull() const {
+    int used = 0;
+    uint64_t n = min<uint64_t>(500, mask_ + 1);
+    for (uint64_t i = 0; i < n; ++i)
+        for (const Entry& e : buckets_[i].entries) {
+            uint64_t data = e.data.load(memory_order_relaxed);
+            used += data && generationOf(data) == generation_;
+        }
+    return int(used * 1000 / (2 * n));
+}
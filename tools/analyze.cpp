@@ -0,0 +1,103 @@
+// Analyze: searches one position and prints the principal variation.
+//
+//   analyze [depth N] [nodes N] [movetime MS] [hash MB] [threads N] [net FILE] [fen]
+//
+// Without limits the search stops at depth 8. The transposition table
+// defaults to 16 MB; "hash 0" searches without one (single-threaded only,
+// since Lazy SMP threads cooperate through the table). The FEN defaults to the start
+// position and may be given as one quoted argument or split over several.
+// "net FILE" evaluates with an NNUE network instead of the built-in terms.
+
+#include "search.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+static const char* const kStartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+static string formatScore(int score) {
+    if (!isMateScore(score)) return "cp " + to_string(score);
+    int plies = kMateScore - abs(score);
+    return "mate " + to_string(score > 0 ? (plies + 1) / 2 : -(plies + 1) / 2);
+}
+
+static void printIteration(const SearchResult& r) {
+    printf("depth %2d  score %-9s  nodes %10llu  nps %9llu  time %6.0fms  pv",
+           r.depth, formatScore(r.score).c_str(), (unsigned long long)r.nodes,
+           (unsigned long long)r.nps, r.seconds * 1000);
+    for (Move m : r.pv) printf(" %s", m.uci().c_str());
+    printf("\n");
+    fflush(stdout);
+}
+
+static int usage() {
+    fprintf(stderr, "usage: analyze [depth N] [nodes N] [movetime MS] [hash MB] [threads N] [net FILE] [fen]\n");
+    return 2;
+}
+
+int main(int argc, char* argv[]) {
+    SearchLimits limits;
+    bool depthGiven = false;
+    int  hashMB     = 16;
+    int  threads    = 1;
+    const char* netPath = nullptr;
+
+    int arg = 1;
+    for (; arg + 1 < argc; arg += 2) {
+        if      (!strcmp(argv[arg], "depth"))    limits.depth      = atoi(argv[arg + 1]), depthGiven = true;
+        else if (!strcmp(argv[arg], "nodes"))    limits.nodes      = strtoull(argv[arg + 1], nullptr, 10);
+        else if (!strcmp(argv[arg], "movetime")) limits.movetimeMs = atoi(argv[arg + 1]);
+        else if (!strcmp(argv[arg], "hash"))     hashMB            = atoi(argv[arg + 1]);
+        else if (!strcmp(argv[arg], "threads"))  threads           = atoi(argv[arg + 1]);
+        else if (!strcmp(argv[arg], "net"))      netPath           = argv[arg + 1];
+        else break;
+    }
+    if (limits.depth < 1 || hashMB < 0 || threads < 1 || (hashMB == 0 && threads > 1)) return usage();
+    // A node or time budget alone searches as deep as it allows.
+    if (!depthGiven && !limits.nodes && !limits.movetimeMs) limits.depth = 8;
+
+    string fen;
+    for (int i = arg; i < argc; ++i) {
+        if (!fen.empty()) fen += ' ';
+        fen += argv[i];
+    }
+    if (fen.empty()) fen = kStartFEN;
+
+    ChessGame game;
+    if (!game.fromFEN(fen)) {
+        fprintf(stderr, "analyze: invalid FEN \"%s\"\n", fen.c_str());
+        return 2;
+    }
+
+    nnue::Network net;
+    if (netPath) {
+        if (!net.load(netPath)) {
+            fprintf(stderr, "analyze: %s\n", net.error().c_str());
+            return 2;
+        }
+        printf("network %s (%s)\n", net.path().c_str(), nnue::simdName(nnue::simd()));
+    }
+
+    unique_ptr<TranspositionTable> tt;
+    SearchResult result;
+    if (hashMB > 0) {
+        tt = make_unique<TranspositionTable>(hashMB);
+        ParallelSearcher searcher(*tt, threads);
+        searcher.setNetwork(&net);
+        result = searcher.run(game, limits, printIteration);
+    } else {
+        Searcher searcher;
+        searcher.setNetwork(&net);
+        result = searcher.run(game, limits, printIteration);
+    }
+    if (tt)
+        printf("hash %zu MB  probes %llu  hit rate %.1f%%  collisions %.2f%%  hashfull %d\n",
+               tt->megabytes(), (unsigned long long)result.tt.probes, result.tt.hitRate() * 100,
+               result.tt.probes ? 100.0 * result.tt.collisions / result.tt.probes : 0.0, result.hashfull);
+    printf("bestmove %s\n", result.bestMove == Move::none() ? "(none)" : result.bestMove.uci().c_str());
+    return 0;
+}
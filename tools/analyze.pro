@@ -0,0 +1,13 @@
+# Headless position analysis (no Qt): runs the alpha-beta searcher on a FEN
+# and prints one line per completed iteration.
+#   qmake tools/analyze.pro && make && ./analyze depth 8
+
+TEMPLATE = app
+TARGET   = analyze
+CONFIG  += console c++17
+CONFIG  -= qt app_bundle
+
+include(../engine.pri)
+
+SOURCES += \
+    analyze.cpp
@@ -0,0 +1,782 @@
+// Headless micro-benchmarks for the rules engine.
+//
+//   bench              run every benchmark
+//   bench <name> ...   run the named benchmarks only
+//
+// Every benchmark reports wall time and the number of heap allocations it
+// caused; the counter is a replacement global operator new below.
+
+#include "chess.h"
+#include "attacks.h"
+#include "search.h"
+#include "history.h"
+#include "nnue.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// ── allocation counter ────────────────────────────────────────────────────────
+static atomic<unsigned long long> gAllocs{0};
+
+void* operator new(size_t n) {
+    gAllocs.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// ── helpers ───────────────────────────────────────────────────────────────────
+using Clock = chrono::steady_clock;
+
+static double secondsSince(Clock::time_point t0) {
+    return chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// Keeps the optimiser from hoisting pure lookups out of the timing loops.
+template <typename T>
+static inline void keep(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile T sink;
+    sink = value;
+#endif
+}
+
+// "e2e4" → (from, to)
+static pair<Position, Position> parseMove(const char* uci) {
+    return { Position(uci[1] - '1', uci[0] - 'a'), Position(uci[3] - '1', uci[2] - 'a') };
+}
+
+// Plays a space-separated list of coordinate moves from the opening position.
+static ChessGame playLine(const char* line) {
+    ChessGame game;
+    for (const char* p = line; *p; ) {
+        while (*p == ' ') ++p;
+        if (!*p) break;
+        auto [from, to] = parseMove(p);
+        if (!game.movePiece(from, to))
+            fprintf(stderr, "bench: illegal move in line \"%s\"\n", line);
+        p += 4;
+    }
+    return game;
+}
+
+static const char* const kLines[] = {
+    "",                                                   // opening position
+    "e2e4 e7e5 g1f3 b8c6 f1c4 f8c5 c2c3 g8f6 d2d4 e5d4",  // Italian, open centre
+    "d2d4 d7d5 c2c4 e7e6 b1c3 g8f6 c1g5 f8e7 e2e3 e8g8",  // QGD, black castled
+};
+
+// All (from, to) pairs getValidMoves reports for the side to move.
+static vector<pair<Position, Position>> candidates(ChessGame& game) {
+    vector<pair<Position, Position>> out;
+    for (int r = 0; r < 8; ++r)
+        for (int c = 0; c < 8; ++c) {
+            const Piece* p = game.getPieceAt(Position(r, c));
+            if (!p || p->getColor() != game.getCurrentTurn()) continue;
+            for (const auto& to : game.getValidMoves(Position(r, c)))
+                out.push_back({ Position(r, c), to });
+        }
+    return out;
+}
+
+// ── benchmarks ────────────────────────────────────────────────────────────────
+
+// Legality probe cost: the old isMoveLegal copied the whole game per
+// candidate; makeMove/unmakeMove plays it in place.
+static void benchLegality() {
+    const int kIters = 2000;
+    printf("legality probe (per candidate move, %d iterations)\n", kIters);
+    printf("  %-34s %12s %12s\n", "method", "ns/probe", "allocs/probe");
+
+    for (const char* line : kLines) {
+        ChessGame game = playLine(line);
+        auto cands = candidates(game);
+        PieceColor side = game.getCurrentTurn();
+        unsigned long long probes = (unsigned long long)kIters * cands.size();
+        int sink = 0;
+
+        unsigned long long a0 = gAllocs;
+        auto t0 = Clock::now();
+        for (int i = 0; i < kIters; ++i)
+            for (const auto& [from, to] : cands) {
+                ChessGame tmp(game);
+                MoveUndo undo;
+                tmp.makeMove(from, to, undo, PieceType::None);
+                sink += tmp.isKingInCheck(side);
+            }
+        double tCopy = secondsSince(t0);
+        unsigned long long aCopy = gAllocs - a0;
+
+        a0 = gAllocs;
+        t0 = Clock::now();
+        for (int i = 0; i < kIters; ++i)
+            for (const auto& [from, to] : cands) {
+                MoveUndo undo;
+                game.makeMove(from, to, undo, PieceType::None);
+                sink += game.isKingInCheck(side);
+                game.unmakeMove(undo);
+            }
+        double tMake = secondsSince(t0);
+        unsigned long long aMake = gAllocs - a0;
+
+        printf(" position: %s\n", *line ? line : "(start)");
+        printf("  %-34s %12.1f %12.2f\n", "copy game per candidate (before)",
+               tCopy * 1e9 / probes, (double)aCopy / probes);
+        printf("  %-34s %12.1f %12.2f\n", "makeMove/unmakeMove (after)",
+               tMake * 1e9 / probes, (double)aMake / probes);
+        if (sink < 0) puts("");   // keep the work observable
+    }
+}
+
+// Attack generation per piece type: Piece::getPossibleMoves' ray walking,
+// the set-wise Kogge-Stone fills in bitboard.h, and the attack tables /
+// magic lookups in attacks.h.
+static void benchAttacks() {
+    const int kIters = 20000;
+    static const PieceType kTypes[] = { PieceType::Pawn, PieceType::Knight, PieceType::Bishop,
+                                        PieceType::Rook, PieceType::Queen, PieceType::King };
+    static const char* const kNames[] = { "pawn", "knight", "bishop", "rook", "queen", "king" };
+#ifdef CHESS_USE_PEXT
+    printf("attack generation (ns per query, sliders via PEXT)\n");
+#else
+    printf("attack generation (ns per query, sliders via magic multiply)\n");
+#endif
+    printf("  %-8s %14s %12s %14s %12s\n", "piece", "ray walk", "allocs", "Kogge-Stone", "table");
+
+    struct Sample { const Piece* piece; int sq; Bitboard occ; array<array<const Piece*, 8>, 8> board; };
+    vector<ChessGame> games;
+    for (const char* line : kLines) games.push_back(playLine(line));
+
+    for (int t = 0; t < 6; ++t) {
+        vector<Sample> samples;
+        for (auto& g : games) {
+            array<array<const Piece*, 8>, 8> board;
+            for (int r = 0; r < 8; ++r)
+                for (int c = 0; c < 8; ++c) board[r][c] = g.getPieceAt(Position(r, c));
+            for (int sq = 0; sq < 64; ++sq) {
+                const Piece* p = board[sq >> 3][sq & 7];
+                if (p && p->getType() == kTypes[t])
+                    samples.push_back({ p, sq, g.state().occupied, board });
+            }
+        }
+        unsigned long long queries = (unsigned long long)kIters * samples.size();
+
+        unsigned long long a0 = gAllocs;
+        auto t0 = Clock::now();
+        for (int i = 0; i < kIters; ++i)
+            for (const auto& s : samples) keep(s.piece->getPossibleMoves(s.board).size());
+        double tRay = secondsSince(t0);
+        double aRay = double(gAllocs - a0) / queries;
+
+        t0 = Clock::now();
+        for (int i = 0; i < kIters; ++i)
+            for (const auto& s : samples) {
+                Bitboard b = bit(s.sq), a = 0;
+                switch (kTypes[t]) {
+                case PieceType::Pawn:   a = pawnAttacks(s.piece->getColor(), b); break;
+                case PieceType::Knight: a = knightAttacks(b); break;
+                case PieceType::Bishop: a = bishopAttacks(b, s.occ); break;
+                case PieceType::Rook:   a = rookAttacks(b, s.occ); break;
+                case PieceType::Queen:  a = rookAttacks(b, s.occ) | bishopAttacks(b, s.occ); break;
+                default:                a = kingAttacks(b); break;
+                }
+                keep(a);
+            }
+        double tFill = secondsSince(t0);
+
+        t0 = Clock::now();
+        for (int i = 0; i < kIters; ++i)
+            for (const auto& s : samples) {
+                Bitboard a = 0;
+                switch (kTypes[t]) {
+                case PieceType::Pawn:   a = attacks::pawn(s.piece->getColor(), s.sq); break;
+                case PieceType::Knight: a = attacks::knight(s.sq); break;
+                case PieceType::Bishop: a = attacks::bishop(s.sq, s.occ); break;
+                case PieceType::Rook:   a = attacks::rook(s.sq, s.occ); break;
+                case PieceType::Queen:  a = attacks::queen(s.sq, s.occ); break;
+                default:                a = attacks::king(s.sq); break;
+                }
+                keep(a);
+            }
+        double tTable = secondsSince(t0);
+
+        printf("  %-8s %14.2f %12.2f %14.2f %12.2f\n", kNames[t],
+               tRay * 1e9 / queries, aRay, tFill * 1e9 / queries, tTable * 1e9 / queries);
+    }
+}
+
+// "Is this square attacked?" — the check-detection predicate. Set-wise union
+// of every attacker's moves versus the reverse lookup from the target square.
+static void benchAttacked() {
+    const int kIters = 20000;
+    printf("square-attacked query (ns per query, all squares, both colours)\n");
+    printf("  %-34s %12s\n", "method", "ns/query");
+
+    vector<ChessGame> games;
+    for (const char* line : kLines) games.push_back(playLine(line));
+    unsigned long long queries = (unsigned long long)kIters * games.size() * 64 * 2;
+
+    auto t0 = Clock::now();
+    for (int i = 0; i < kIters; ++i)
+        for (const auto& g : games)
+            for (PieceColor by : { PieceColor::White, PieceColor::Black })
+                for (int sq = 0; sq < 64; ++sq) keep(bool(g.state().attacksBy(by) & bit(sq)));
+    double tUnion = secondsSince(t0);
+
+    t0 = Clock::now();
+    for (int i = 0; i < kIters; ++i)
+        for (const auto& g : games)
+            for (PieceColor by : { PieceColor::White, PieceColor::Black })
+                for (int sq = 0; sq < 64; ++sq) keep(attacks::isAttacked(g.state(), sq, by));
+    double tReverse = secondsSince(t0);
+
+    printf("  %-34s %12.2f\n", "union of attacker moves", tUnion * 1e9 / queries);
+    printf("  %-34s %12.2f\n", "reverse lookup, early exit", tReverse * 1e9 / queries);
+}
+
+// Repetition keys must survive a line longer than the game's key ring that
+// is made and then taken back: a knight shuffle brings the opening position
+// round a second time, random moves wander off and are unmade, and one more
+// shuffle must then be the third occurrence.
+static bool repetitionsSurviveTakeBack(int& plies) {
+    ChessGame game = playLine("g1f3 g8f6 f3g1 f6g8");
+    bool ok = game.repetitions(3) == 1;
+    MoveUndo undos[200];
+    unsigned long long seed = 2024;
+    for (plies = 0; plies < 200; ++plies) {
+        MoveList moves;
+        game.generateLegalMoves(moves);
+        if (moves.empty()) break;
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        game.makeMove(moves[int((seed >> 33) % unsigned(moves.size()))], undos[plies]);
+    }
+    for (int i = plies; i > 0; --i) game.unmakeMove(undos[i - 1]);
+    ok &= game.repetitions(3) == 1;
+    for (const char* m : { "g1f3", "g8f6", "f3g1", "f6g8" }) {
+        auto [from, to] = parseMove(m);
+        ok &= game.movePiece(from, to);
+    }
+    return ok && game.drawReason() == ChessGame::DrawReason::Repetition;
+}
+
+// Game-over adjudication and full legal move generation — what bulk
+// checkmate/stalemate scans over a game database pay per position.
+static void benchAdjudicate() {
+    const int kIters = 20000;
+    static const char* const kFens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3",   // fool's mate
+        "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1",                                  // stalemate
+        "R5k1/5ppp/8/8/8/8/8/6K1 b - - 0 1",                               // back-rank mate
+    };
+    int  plies;
+    bool rewound = repetitionsSurviveTakeBack(plies);
+    printf("adjudication (per position, %d iterations; repetitions after a %d-ply take-back %s)\n",
+           kIters, plies, rewound ? "ok" : "WRONG");
+    printf("  %-12s %18s %18s %10s\n", "position", "mate+stalemate ns", "legal movegen ns", "allocs");
+
+    int idx = 0;
+    for (const char* fen : kFens) {
+        ChessGame game;
+        game.fromFEN(fen);
+        PieceColor side = game.getCurrentTurn();
+
+        unsigned long long a0 = gAllocs;
+        auto t0 = Clock::now();
+        for (int i = 0; i < kIters; ++i) {
+            keep(game.isCheckmate(side));
+            keep(game.isStalemate(side));
+        }
+        double tMate = secondsSince(t0);
+
+        t0 = Clock::now();
+        for (int i = 0; i < kIters; ++i) {
+            MoveList moves;
+            game.generateLegalMoves(moves);
+            keep(moves.size());
+        }
+        double tGen = secondsSince(t0);
+
+        char name[16];
+        snprintf(name, sizeof name, "#%d", ++idx);
+        printf("  %-12s %18.1f %18.1f %10.2f\n", name, tMate * 1e9 / kIters, tGen * 1e9 / kIters,
+               double(gAllocs - a0) / kIters);
+    }
+}
+
+// FEN throughput: the zero-allocation parser alone, the full import that
+// also rebuilds the Piece view, and export. Round trips are checked first
+// so a fast but wrong parser cannot pass.
+static void benchFen() {
+    const int kIters = 200000;
+    static const char* const kFens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1",
+        "6k1/5ppp/8/8/8/8/5PPP/3R2K1 b - - 37 112",
+    };
+    const int kCount = int(sizeof kFens / sizeof kFens[0]);
+
+    int bad = 0;
+    for (const char* fen : kFens) {
+        ChessGame game;
+        if (!game.fromFEN(fen) || game.toFEN() != fen) {
+            fprintf(stderr, "bench: FEN round trip failed for \"%s\"\n", fen);
+            ++bad;
+        }
+    }
+    printf("FEN (%d positions x %d iterations%s)\n", kCount, kIters, bad ? ", ROUND TRIP FAILED" : "");
+    printf("  %-34s %12s %12s %12s\n", "method", "ns/FEN", "FEN/s", "allocs/FEN");
+
+    auto report = [&](const char* name, double secs, unsigned long long allocs) {
+        double n = double(kIters) * kCount;
+        printf("  %-34s %12.1f %12.0f %12.2f\n", name, secs * 1e9 / n, n / secs, allocs / n);
+    };
+
+    BoardState state;
+    unsigned long long a0 = gAllocs;
+    auto t0 = Clock::now();
+    for (int i = 0; i < kIters; ++i)
+        for (const char* fen : kFens) {
+            keep(ChessGame::parseFEN(fen, state));
+            keep(state.occupied);
+        }
+    report("parseFEN (BoardState only)", secondsSince(t0), gAllocs - a0);
+
+    ChessGame game;
+    a0 = gAllocs;
+    t0 = Clock::now();
+    for (int i = 0; i < kIters; ++i)
+        for (const char* fen : kFens) keep(game.fromFEN(fen));
+    report("fromFEN (with piece view)", secondsSince(t0), gAllocs - a0);
+
+    ChessGame games[kCount];
+    for (int i = 0; i < kCount; ++i) games[i].fromFEN(kFens[i]);
+    size_t chars = 0;
+    a0 = gAllocs;
+    t0 = Clock::now();
+    for (int i = 0; i < kIters; ++i)
+        for (const ChessGame& g : games) chars += g.toFEN().size();
+    report("toFEN", secondsSince(t0), gAllocs - a0);
+    keep(chars);
+}
+
+// Move-history navigation over a long game: MoveHistory steps with
+// make/unmake, against keeping a ChessGame snapshot per ply. The game opens
+// with a knight shuffle, and jumping back from the end to every ply must
+// give the repetition count and draw verdict seen when it was first played.
+static void benchHistory() {
+    const int kPlies = 300, kJumps = 2000;
+    ChessGame game;
+    MoveHistory history;
+    vector<pair<int, ChessGame::DrawReason>> draws;   // by ply, as played
+    auto record = [&] { draws.emplace_back(game.repetitions(3), game.drawReason()); };
+    auto shuffle = [&] {
+        for (const char* m : { "g1f3", "g8f6", "f3g1", "f6g8" }) {
+            auto [from, to] = parseMove(m);
+            history.play(game, Move(from.row * 8 + from.col, to.row * 8 + to.col));
+            record();
+        }
+    };
+    record();
+    shuffle();
+    unsigned long long seed = 12345;
+    while (history.length() < kPlies) {
+        MoveList moves;
+        game.generateLegalMoves(moves);
+        if (moves.empty()) {   // game over early: start again
+            history.jumpTo(game, 0);
+            history.clear();
+            draws.clear();
+            record();
+            shuffle();
+            continue;
+        }
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        history.play(game, moves[int((seed >> 33) % unsigned(moves.size()))]);
+        record();
+    }
+    bool drawsOk = true;
+    for (int ply = kPlies; ply >= 0; --ply) {
+        history.jumpTo(game, kPlies);
+        history.jumpTo(game, ply);
+        drawsOk &= draws[size_t(ply)] == make_pair(game.repetitions(3), game.drawReason());
+    }
+    printf("move history (%d-ply game, %d jumps end <-> start; draw state after jumping back %s)\n",
+           kPlies, kJumps, drawsOk ? "ok" : "WRONG");
+    printf("  %-34s %10s %12s %10s %12s\n", "method", "us/jump", "allocs/jump", "bytes/ply",
+           "allocs/ply");
+
+    unsigned long long a0 = gAllocs;
+    auto t0 = Clock::now();
+    for (int i = 0; i < kJumps; ++i) {
+        history.jumpTo(game, i % 2 ? kPlies : 0);
+        keep(game.hash());
+    }
+    double tJump = secondsSince(t0);
+    // Each ply stores a Move and a MoveUndo and nothing else; captured
+    // pieces stay parked in the game's piece pool.
+    printf("  %-34s %10.2f %12.2f %10zu %12s\n", "MoveHistory (make/unmake)", tJump * 1e6 / kJumps,
+           double(gAllocs - a0) / kJumps, sizeof(Move) + sizeof(MoveUndo), "-");
+
+    // Snapshot per ply: jumping is one assignment, but every ply holds a
+    // whole ChessGame.
+    history.jumpTo(game, 0);
+    a0 = gAllocs;
+    vector<ChessGame> snapshots;
+    snapshots.reserve(kPlies + 1);
+    snapshots.push_back(game);
+    for (int i = 0; i < kPlies; ++i) {
+        history.redo(game);
+        snapshots.push_back(game);
+    }
+    unsigned long long aBuild = gAllocs - a0;
+    a0 = gAllocs;
+    t0 = Clock::now();
+    for (int i = 0; i < kJumps; ++i) {
+        game = snapshots[i % 2 ? kPlies : 0];
+        keep(game.hash());
+    }
+    double tCopy = secondsSince(t0);
+    printf("  %-34s %10.2f %12.2f %10zu %12.2f\n", "ChessGame snapshot per ply", tCopy * 1e6 / kJumps,
+           double(gAllocs - a0) / kJumps, sizeof(ChessGame), double(aBuild) / (kPlies + 1));
+}
+
+// What a ChessGame costs to hold and to copy: the object size, a copy
+// (what every search thread and every snapshot pays), and the heap traffic
+// of setting up a game and playing it to the end with random legal moves.
+static void benchCopy() {
+    const int kCopies = 200000, kGames = 2000;
+    printf("ChessGame copy (sizeof %zu bytes)\n", sizeof(ChessGame));
+    printf("  %-34s %12s %12s\n", "position", "ns/copy", "allocs/copy");
+
+    vector<ChessGame> games;
+    for (const char* line : kLines) games.push_back(playLine(line));
+    for (size_t i = 0; i < games.size(); ++i) {
+        unsigned long long a0 = gAllocs;
+        auto t0 = Clock::now();
+        for (int n = 0; n < kCopies; ++n) {
+            ChessGame copy(games[i]);
+            keep(&copy);   // the whole object must really be written
+        }
+        double secs = secondsSince(t0);
+        printf("  %-34.34s %12.1f %12.2f\n", *kLines[i] ? kLines[i] : "(start)",
+               secs * 1e9 / kCopies, double(gAllocs - a0) / kCopies);
+    }
+
+    unsigned long long seed = 12345, plies = 0;
+    unsigned long long a0 = gAllocs;
+    auto t0 = Clock::now();
+    for (int g = 0; g < kGames; ++g) {
+        ChessGame game;
+        for (;;) {
+            MoveList moves;
+            game.generateLegalMoves(moves);
+            if (moves.empty() || game.drawReason() != ChessGame::DrawReason::None) break;
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            MoveUndo undo;
+            game.makeMove(moves[int((seed >> 33) % unsigned(moves.size()))], undo);
+            ++plies;
+        }
+        keep(game.hash());
+    }
+    double secs = secondsSince(t0);
+    printf("  %-34s %12.1f %12.2f   (%.0f plies/game)\n", "new game + random playout (us, /game)",
+           secs * 1e6 / kGames, double(gAllocs - a0) / kGames, double(plies) / kGames);
+}
+
+// Static evaluation over positions from random playouts. First a check:
+// the terms ChessGame keeps must equal a from-scratch recompute after every
+// make and every unmake. Then leaf cost: the tapered score of the kept
+// terms, against recomputing them, against the old material-only count.
+static void benchEval() {
+    const int kGames = 400, kPasses = 50;
+    vector<BoardState>  states;
+    vector<eval::Terms> terms;
+    unsigned long long seed = 12345, checked = 0, bad = 0;
+    for (int g = 0; g < kGames; ++g) {
+        ChessGame game;
+        vector<MoveUndo> undos;
+        auto check = [&] {
+            ++checked;
+            if (game.evalTerms() != eval::termsOf(game.state()) && !bad++)
+                fprintf(stderr, "bench: evaluation terms diverged at %s\n", game.toFEN().c_str());
+        };
+        for (;;) {
+            MoveList moves;
+            game.generateLegalMoves(moves);
+            if (moves.empty() || game.drawReason() != ChessGame::DrawReason::None) break;
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            undos.emplace_back();
+            game.makeMove(moves[int((seed >> 33) % unsigned(moves.size()))], undos.back());
+            check();
+            states.push_back(game.state());
+            terms.push_back(game.evalTerms());
+        }
+        while (!undos.empty()) {
+            game.unmakeMove(undos.back());
+            undos.pop_back();
+            check();
+        }
+    }
+    const double n = double(states.size()) * kPasses;
+    printf("evaluation (%zu positions from %d random games, %llu make/unmake checks%s)\n",
+           states.size(), kGames, checked, bad ? ", TERMS DIVERGED" : " ok");
+    printf("  %-34s %12s %14s\n", "method", "ns/eval", "evals/s");
+    auto report = [&](const char* name, double secs) {
+        printf("  %-34s %12.2f %14.0f\n", name, secs * 1e9 / n, n / secs);
+    };
+
+    long long sum = 0;
+    auto t0 = Clock::now();
+    for (int p = 0; p < kPasses; ++p)
+        for (size_t i = 0; i < states.size(); ++i) {
+            keep(terms[i]);
+            sum += eval::score(terms[i], states[i].sideToMove);
+        }
+    report("tapered, incremental terms", secondsSince(t0));
+
+    t0 = Clock::now();
+    for (int p = 0; p < kPasses; ++p)
+        for (const BoardState& s : states) sum += eval::score(eval::termsOf(s), s.sideToMove);
+    report("tapered, terms from scratch", secondsSince(t0));
+
+    static const int kValue[] = { 0, 100, 500, 320, 330, 900, 0 };
+    t0 = Clock::now();
+    for (int p = 0; p < kPasses; ++p)
+        for (const BoardState& s : states) {
+            int score = 0;
+            for (int t = int(PieceType::Pawn); t <= int(PieceType::Queen); ++t)
+                score += kValue[t] * (popCount(s.of(PieceColor::White, PieceType(t)))
+                                    - popCount(s.of(PieceColor::Black, PieceType(t))));
+            sum += s.sideToMove == PieceColor::White ? score : -score;
+        }
+    report("material only, from scratch", secondsSince(t0));
+    keep(sum);
+}
+
+// NNUE cost per node with each kernel the CPU runs, on a random network
+// (written to a temporary file and mapped like any other): the accumulator
+// kept up to date move by move as the search does it, against rebuilding
+// it from scratch at every node, and the dense layers every evaluation
+// pays either way. Accumulators and outputs are checked first: incremental
+// against refresh, every kernel against plain C++.
+static void benchNnue() {
+    const int kGames = 300, kMaxPlies = 100, kPasses = 5;
+    const string path = (filesystem::temp_directory_path() / "bench-random.nnue").string();
+    string error;
+    if (!nnue::Network::writeRandom(path, 12345, &error)) {
+        fprintf(stderr, "bench: %s\n", error.c_str());
+        return;
+    }
+    {
+        nnue::Network net;
+        if (!net.load(path)) {
+            fprintf(stderr, "bench: %s\n", net.error().c_str());
+            return;
+        }
+
+        // Random games, cut at kMaxPlies: the stack holds a search's depth.
+        struct Game { BoardState root; vector<BoardChanges> changes; vector<BoardState> states; };
+        vector<Game> games(kGames);
+        unsigned long long seed = 12345, nodes = 0;
+        for (Game& g : games) {
+            ChessGame game;
+            g.root = game.state();
+            while (int(g.states.size()) < kMaxPlies) {
+                MoveList moves;
+                game.generateLegalMoves(moves);
+                if (moves.empty() || game.drawReason() != ChessGame::DrawReason::None) break;
+                seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                MoveUndo undo;
+                game.makeMove(moves[int((seed >> 33) % unsigned(moves.size()))], undo);
+                g.changes.push_back(undo.changes);
+                g.states.push_back(game.state());
+            }
+            nodes += g.states.size();
+        }
+
+        auto stack = make_unique<nnue::AccumulatorStack>();
+        nnue::Accumulator fresh;
+        unsigned long long mismatches = 0;
+        vector<int> reference;
+        const nnue::Simd best = nnue::bestSimd();
+        for (nnue::Simd s : { nnue::Simd::Scalar, nnue::Simd::Sse2, nnue::Simd::Avx2 }) {
+            if (s > best) break;
+            nnue::setSimd(s);
+            size_t at = 0;
+            for (const Game& g : games) {
+                stack->reset();
+                stack->update(net, 0, g.root);
+                for (size_t ply = 1; ply <= g.states.size(); ++ply) {
+                    const BoardState& state = g.states[ply - 1];
+                    stack->push(int(ply), g.changes[ply - 1]);
+                    const nnue::Accumulator& acc = stack->update(net, int(ply), state);
+                    nnue::refresh(net, state, PieceColor::White, fresh);
+                    nnue::refresh(net, state, PieceColor::Black, fresh);
+                    int score = nnue::propagate(net, acc, state.sideToMove);
+                    if (s == nnue::Simd::Scalar) reference.push_back(score);
+                    mismatches += memcmp(&acc, &fresh, sizeof fresh) != 0 || score != reference[at];
+                    ++at;
+                }
+            }
+        }
+        stack->refreshes = stack->incremental = 0;
+
+        printf("NNUE (%d inputs -> 2x%d -> %d -> %d -> 1, %llu positions from %d random games%s)\n",
+               nnue::kFeatures, nnue::kHalfDims, nnue::kHidden, nnue::kHidden, nodes, kGames,
+               mismatches ? ", KERNELS / UPDATES DISAGREE" : ", checked");
+        printf("  %-8s %12s %12s %12s %14s %14s\n", "kernel", "incremental", "refresh", "dense",
+               "eval (incr.)", "eval (refresh)");
+        const double n = double(nodes) * kPasses;
+        for (nnue::Simd s : { nnue::Simd::Scalar, nnue::Simd::Sse2, nnue::Simd::Avx2 }) {
+            if (s > best) break;
+            nnue::setSimd(s);
+
+            auto t0 = Clock::now();
+            for (int p = 0; p < kPasses; ++p)
+                for (const Game& g : games) {
+                    stack->reset();
+                    stack->update(net, 0, g.root);
+                    for (size_t ply = 1; ply <= g.states.size(); ++ply) {
+                        stack->push(int(ply), g.changes[ply - 1]);
+                        keep(&stack->update(net, int(ply), g.states[ply - 1]));
+                    }
+                }
+            double tIncremental = secondsSince(t0);
+
+            t0 = Clock::now();
+            for (int p = 0; p < kPasses; ++p)
+                for (const Game& g : games)
+                    for (const BoardState& state : g.states) {
+                        nnue::refresh(net, state, PieceColor::White, fresh);
+                        nnue::refresh(net, state, PieceColor::Black, fresh);
+                        keep(&fresh);
+                    }
+            double tRefresh = secondsSince(t0);
+
+            long long sum = 0;
+            t0 = Clock::now();
+            for (int p = 0; p < kPasses; ++p)
+                for (const Game& g : games)
+                    for (const BoardState& state : g.states) sum += nnue::propagate(net, fresh, state.sideToMove);
+            double tDense = secondsSince(t0);
+            keep(sum);
+
+            printf("  %-8s %10.1fns %10.1fns %10.1fns %12.1fns %12.1fns\n", nnue::simdName(s),
+                   tIncremental * 1e9 / n, tRefresh * 1e9 / n, tDense * 1e9 / n,
+                   (tIncremental + tDense) * 1e9 / n, (tRefresh + tDense) * 1e9 / n);
+        }
+        nnue::setSimd(best);
+        // Two perspectives per node; the first position of a game is always a refresh.
+        printf("  incremental: %.1f%% of perspective updates were refreshes (king moves, game starts)\n",
+               100.0 * stack->refreshes / double(stack->refreshes + stack->incremental));
+
+        // The same searches with the built-in evaluation and the network.
+        TranspositionTable tt(16);
+        Searcher searcher(&tt);
+        SearchLimits limits;
+        limits.depth = 6;
+        printf("  %-34s %12s %12s\n", "search (depth 6, start position)", "nodes", "nps");
+        const nnue::Network* const nets[] = { nullptr, &net };
+        for (const nnue::Network* with : nets) {
+            tt.clear();
+            searcher.setNetwork(with);
+            SearchResult r = searcher.run(ChessGame(), limits);
+            printf("  %-34s %12llu %12llu\n", with ? nnue::simdName(best) : "built-in evaluation",
+                   (unsigned long long)r.nodes, (unsigned long long)r.nps);
+        }
+    }
+    filesystem::remove(path);
+}
+
+// Lazy SMP scaling: the same fixed-depth search of each position with 1 to
+// 16 threads, from an empty table each time. Time-to-depth shows what the
+// extra threads buy; nodes/second shows how well they run side by side.
+// Thread counts above the hardware's only measure oversubscription.
+static void benchSmp() {
+    const int kDepth = 7;
+    static const char* const kFens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+    printf("lazy SMP scaling (depth %d, %zu positions, %u hardware threads)\n",
+           kDepth, size(kFens), thread::hardware_concurrency());
+    printf("  %-8s %14s %10s %14s %10s\n", "threads", "time-to-depth", "speedup", "nps", "nps x");
+
+    TranspositionTable tt(64);
+    double baseSecs = 0, baseNps = 0;
+    for (int threads : { 1, 2, 4, 8, 16 }) {
+        ParallelSearcher searcher(tt, threads);
+        double secs = 0;
+        unsigned long long nodes = 0;
+        for (const char* fen : kFens) {
+            ChessGame game;
+            game.fromFEN(fen);
+            tt.clear();
+            SearchLimits limits;
+            limits.depth = kDepth;
+            SearchResult r = searcher.run(game, limits);
+            secs  += r.seconds;
+            nodes += r.nodes;
+        }
+        double nps = nodes / secs;
+        if (threads == 1) { baseSecs = secs; baseNps = nps; }
+        printf("  %-8d %12.0fms %9.2fx %14.0f %9.2fx\n", threads, secs * 1000,
+               baseSecs / secs, nps, nps / baseNps);
+    }
+}
+
+static const struct { const char* name; void (*run)(); } kBenches[] = {
+    { "legality", benchLegality },
+    { "attacks",  benchAttacks  },
+    { "attacked", benchAttacked },
+    { "adjudicate", benchAdjudicate },
+    { "fen",      benchFen      },
+    { "history",  benchHistory  },
+    { "copy",     benchCopy     },
+    { "eval",     benchEval     },
+    { "nnue",     benchNnue     },
+    { "smp",      benchSmp      },
+};
+
+int main(int argc, char* argv[]) {
+    bool any = false;
+    for (const auto& b : kBenches) {
+        bool wanted = (argc < 2);
+        for (int i = 1; i < argc; ++i)
+            if (!strcmp(argv[i], b.name)) wanted = true;
+        if (!wanted) continue;
+        b.run();
+        any = true;
+    }
+    if (!any) {
+        fprintf(stderr, "usage: bench [");
+        for (const auto& b : kBenches) fprintf(stderr, " %s", b.name);
+        fprintf(stderr, " ]\n");
+        return 1;
+    }
+    return 0;
+}
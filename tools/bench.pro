@@ -0,0 +1,12 @@
+# Headless engine micro-benchmarks (no Qt).
+#   qmake tools/bench.pro && make && ./bench
+
+TEMPLATE = app
+TARGET   = bench
+CONFIG  += console c++17
+CONFIG  -= qt app_bundle
+
+include(../engine.pri)
+
+SOURCES += \
+    bench.cpp
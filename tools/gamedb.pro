@@ -0,0 +1,12 @@
+# Binary game database (no Qt): PGN import/export and random-access timing.
+#   qmake tools/gamedb.pro && make && ./gamedb import games.pgn games
+
+TEMPLATE = app
+TARGET   = gamedb
+CONFIG  += console c++17
+CONFIG  -= qt app_bundle
+
+include(../engine.pri)
+
+SOURCES += \
+    gamedb.cpp
@@ -0,0 +1,403 @@
+// Match: engine-versus-engine games on all cores, for regression testing
+// changes to move generation, search and evaluation.
+//
+//   match [-j threads] [-n games] [-o games.pgn] [-openings file]
+//         [-plies N] [-a spec] [-b spec]
+//
+// Players A and B are the searcher with their own limits; a spec is a
+// comma-separated list of depth=N, nodes=N, movetime=MS, hash=MB, net=FILE
+// and name=TEXT (default for both: nodes=20000, hash=16, the built-in
+// evaluation). Node limits make a match reproducible; time limits do not,
+// and shrink with oversubscription. A network is mapped once and shared by
+// every thread.
+//
+// Every opening is played twice, A taking White and then Black. Openings
+// come from a file with one FEN (or EPD: operations after the fourth field
+// are dropped) per line, or from a built-in list of common opening lines.
+// A game ends on checkmate, stalemate, threefold repetition, the fifty-move
+// rule or insufficient material, or is adjudicated a draw at the ply limit
+// (default 400).
+//
+// Each game runs on one pool thread with that thread's own searchers and
+// transposition tables, cleared before the game, so games never share
+// state. Results are reported from A's point of view after every batch:
+// wins/draws/losses, score and an Elo difference with its 95% interval;
+// the summary adds games/hour and each player's nodes/second.
+
+#include "gamedb.h"
+#include "search.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+static double secondsSince(Clock::time_point t0) {
+    return chrono::duration<double>(Clock::now() - t0).count();
+}
+
+struct Player {
+    string       name;
+    SearchLimits limits;
+    int          hashMB = 16;
+    string       net;   // NNUE network file, empty for the built-in evaluation
+};
+
+// A start position plus coordinate moves played from it before the engines
+// take over; the moves are part of the recorded game.
+struct Opening {
+    string         fen;   // empty: standard start position
+    vector<string> moves;
+};
+
+static const char* const kOpeningLines[] = {
+    "e2e4 e7e5 g1f3 b8c6",   // open game
+    "e2e4 c7c5 g1f3 d7d6",   // Sicilian
+    "e2e4 e7e6 d2d4 d7d5",   // French
+    "e2e4 c7c6 d2d4 d7d5",   // Caro-Kann
+    "d2d4 d7d5 c2c4 e7e6",   // Queen's Gambit Declined
+    "d2d4 g8f6 c2c4 g7g6",   // King's Indian
+    "c2c4 e7e5 b1c3 g8f6",   // English
+    "g1f3 d7d5 g2g3 g8f6",   // Reti
+};
+
+// Everything kept of a finished game.
+struct GameRecord {
+    GameResult    result = GameResult::Unknown;
+    const char*   termination = "";
+    bool          aWhite = true;
+    int           plies  = 0;
+    std::uint64_t nodes[2]   = { 0, 0 };   // by player: A, B
+    double        seconds[2] = { 0, 0 };
+    string        pgn;
+};
+
+// Per-thread engines: one searcher and table per player, so neither
+// side's hash entries leak into the other's search.
+struct Worker {
+    TranspositionTable tt[2];
+    Searcher           searcher[2];
+
+    Worker(const Player players[2], const nnue::Network nets[2])
+        : tt{ TranspositionTable(size_t(players[0].hashMB)), TranspositionTable(size_t(players[1].hashMB)) },
+          searcher{ Searcher(&tt[0]), Searcher(&tt[1]) } {
+        for (int p = 0; p < 2; ++p) searcher[p].setNetwork(&nets[p]);
+    }
+};
+
+static vector<string> split(const string& text, char sep) {
+    vector<string> parts;
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        size_t end = min(text.find(sep, begin), text.size());
+        if (end > begin) parts.push_back(text.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return parts;
+}
+
+static bool parsePlayer(const string& spec, Player& p) {
+    for (const string& item : split(spec, ',')) {
+        size_t eq = item.find('=');
+        if (eq == string::npos) return false;
+        string key = item.substr(0, eq), value = item.substr(eq + 1);
+        long long n = atoll(value.c_str());
+        if      (key == "name")     p.name = value;
+        else if (key == "depth"    && n > 0)  p.limits.depth      = int(min<long long>(n, kMaxPly - 1));
+        else if (key == "nodes"    && n > 0)  p.limits.nodes      = uint64_t(n);
+        else if (key == "movetime" && n > 0)  p.limits.movetimeMs = int(n);
+        else if (key == "hash"     && n > 0)  p.hashMB            = int(n);
+        else if (key == "net"      && !value.empty()) p.net       = value;
+        else return false;
+    }
+    return true;
+}
+
+static bool loadOpenings(const char* path, vector<Opening>& out) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[512];
+    while (fgets(line, sizeof line, f)) {
+        vector<string> fields = split(string(line, strcspn(line, "\r\n")), ' ');
+        if (fields.empty() || fields[0][0] == '#') continue;
+        // Keep the move counters of a full FEN, drop EPD operations.
+        bool counters = fields.size() >= 6 && isdigit((unsigned char)fields[4][0]) &&
+                        isdigit((unsigned char)fields[5][0]);
+        fields.resize(min(fields.size(), size_t(counters ? 6 : 4)));
+        Opening o;
+        for (const string& field : fields) o.fen += (o.fen.empty() ? "" : " ") + field;
+        BoardState check;
+        if (!ChessGame::parseFEN(o.fen, check)) {
+            fprintf(stderr, "match: %s: invalid FEN \"%s\"\n", path, o.fen.c_str());
+            fclose(f);
+            return false;
+        }
+        out.push_back(move(o));
+    }
+    fclose(f);
+    return !out.empty();
+}
+
+static Move findMove(const ChessGame& game, const string& uci) {
+    MoveList moves;
+    game.generateLegalMoves(moves);
+    for (Move m : moves)
+        if (m.uci() == uci) return m;
+    return Move::none();
+}
+
+static string today() {
+    time_t now = time(nullptr);
+    char buf[16];
+    strftime(buf, sizeof buf, "%Y.%m.%d", localtime(&now));
+    return buf;
+}
+
+// The settings every game reads; fixed before the first game starts.
+struct Match {
+    Player          players[2];
+    vector<Opening> openings;
+    int             maxPlies = 400;
+    string          date;   // PGN Date tag, read once: localtime() is not thread-safe
+};
+
+static void playGame(size_t index, const Match& match, Worker& w, GameRecord& rec) {
+    const Opening& opening = match.openings[(index / 2) % match.openings.size()];
+    const Player*  players = match.players;
+    rec = GameRecord();
+    rec.aWhite = index % 2 == 0;
+
+    ChessGame    game;
+    vector<Move> moves;
+    if (!opening.fen.empty()) game.fromFEN(opening.fen);
+    for (const string& uci : opening.moves) {
+        Move m = findMove(game, uci);
+        if (m == Move::none()) break;
+        MoveUndo undo;
+        game.makeMove(m, undo);
+        moves.push_back(m);
+    }
+    w.tt[0].clear();
+    w.tt[1].clear();
+
+    for (;;) {
+        PieceColor turn = game.getCurrentTurn();
+        if (game.isCheckmate(turn)) {
+            rec.result = turn == PieceColor::White ? GameResult::BlackWins : GameResult::WhiteWins;
+            rec.termination = "checkmate";
+            break;
+        }
+        if (game.isStalemate(turn)) {
+            rec.result = GameResult::Draw;
+            rec.termination = "stalemate";
+            break;
+        }
+        ChessGame::DrawReason draw = game.drawReason();
+        if (draw != ChessGame::DrawReason::None) {
+            rec.result = GameResult::Draw;
+            rec.termination = draw == ChessGame::DrawReason::Repetition ? "threefold repetition"
+                            : draw == ChessGame::DrawReason::FiftyMoves ? "fifty-move rule"
+                                                                        : "insufficient material";
+            break;
+        }
+        if (rec.plies >= match.maxPlies) {
+            rec.result = GameResult::Draw;
+            rec.termination = "ply limit";
+            break;
+        }
+
+        int player = (turn == PieceColor::White) == rec.aWhite ? 0 : 1;
+        SearchResult r = w.searcher[player].run(game, players[player].limits);
+        rec.nodes[player]   += r.nodes;
+        rec.seconds[player] += r.seconds;
+        MoveUndo undo;
+        game.makeMove(r.bestMove, undo);
+        moves.push_back(r.bestMove);
+        ++rec.plies;
+    }
+
+    vector<PgnTag> tags = {
+        { "Event",  "ChessGame match" },
+        { "Site",   "?" },
+        { "Date",   match.date },
+        { "Round",  to_string(index + 1) },
+        { "White",  players[rec.aWhite ? 0 : 1].name },
+        { "Black",  players[rec.aWhite ? 1 : 0].name },
+        { "Result", string(resultText(rec.result)) },
+    };
+    if (!opening.fen.empty()) {
+        tags.push_back({ "SetUp", "1" });
+        tags.push_back({ "FEN", opening.fen });
+    }
+    tags.push_back({ "Termination", rec.termination });
+    formatPgn(tags, moves, rec.pgn);
+}
+
+// Wins, draws and losses of player A.
+struct Score {
+    unsigned long long wins = 0, draws = 0, losses = 0;
+
+    unsigned long long games() const { return wins + draws + losses; }
+    double fraction() const { return games() ? (wins + 0.5 * draws) / games() : 0.5; }
+
+    // Logistic Elo difference for a score, and the 95% interval from the
+    // per-game score variance (trinomial: win 1, draw 1/2, loss 0).
+    static double elo(double score) {
+        score = clamp(score, 1e-6, 1 - 1e-6);
+        return 400 * log10(score / (1 - score));
+    }
+    void eloInterval(double& diff, double& margin) const {
+        double n = double(games()), s = fraction();
+        diff = elo(s);
+        margin = 0;
+        if (n < 2) return;
+        double var = (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / n;
+        double se  = sqrt(var / n);
+        margin = (elo(s + 1.96 * se) - elo(s - 1.96 * se)) / 2;
+    }
+};
+
+static void printScore(const Score& s) {
+    double diff, margin;
+    s.eloInterval(diff, margin);
+    printf("+%llu =%llu -%llu  score %.1f%%  Elo %+.1f +/- %.1f", s.wins, s.draws, s.losses,
+           s.fraction() * 100, diff, margin);
+}
+
+static int usage() {
+    fprintf(stderr,
+            "usage: match [-j threads] [-n games] [-o games.pgn] [-openings file]\n"
+            "             [-plies N] [-a spec] [-b spec]\n"
+            "  spec: depth=N,nodes=N,movetime=MS,hash=MB,net=FILE,name=TEXT\n");
+    return 2;
+}
+
+int main(int argc, char* argv[]) {
+    Match   match;
+    Player* players = match.players;
+    players[0].name = "A";
+    players[1].name = "B";
+    for (int p = 0; p < 2; ++p) players[p].limits.nodes = 20000;
+
+    int         threads = 0;
+    long long   count   = 100;
+    const char* pgnPath = nullptr;
+    const char* openingsPath = nullptr;
+    for (int arg = 1; arg < argc; ++arg) {
+        bool value = arg + 1 < argc;
+        if      (!strcmp(argv[arg], "-j") && value)        threads      = atoi(argv[++arg]);
+        else if (!strcmp(argv[arg], "-n") && value)        count        = atoll(argv[++arg]);
+        else if (!strcmp(argv[arg], "-o") && value)        pgnPath      = argv[++arg];
+        else if (!strcmp(argv[arg], "-openings") && value) openingsPath = argv[++arg];
+        else if (!strcmp(argv[arg], "-plies") && value)    match.maxPlies = atoi(argv[++arg]);
+        else if (!strcmp(argv[arg], "-a") && value) { if (!parsePlayer(argv[++arg], players[0])) return usage(); }
+        else if (!strcmp(argv[arg], "-b") && value) { if (!parsePlayer(argv[++arg], players[1])) return usage(); }
+        else return usage();
+    }
+    if (threads < 0 || count < 1 || match.maxPlies < 1) return usage();
+    match.date = today();
+
+    vector<Opening>& openings = match.openings;
+    if (openingsPath) {
+        if (!loadOpenings(openingsPath, openings)) {
+            fprintf(stderr, "match: no openings read from %s\n", openingsPath);
+            return 2;
+        }
+    } else {
+        for (const char* line : kOpeningLines) openings.push_back({ "", split(line, ' ') });
+    }
+
+    FILE* pgnFile = nullptr;
+    if (pgnPath && !(pgnFile = fopen(pgnPath, "w"))) {
+        fprintf(stderr, "match: cannot write %s\n", pgnPath);
+        return 2;
+    }
+
+    nnue::Network nets[2];
+    for (int p = 0; p < 2; ++p)
+        if (!players[p].net.empty() && !nets[p].load(players[p].net)) {
+            fprintf(stderr, "match: %s\n", nets[p].error().c_str());
+            return 2;
+        }
+
+    ThreadPool pool(threads);
+    vector<unique_ptr<Worker>> workers;
+    for (int i = 0; i < pool.size(); ++i) workers.push_back(make_unique<Worker>(players, nets));
+    printf("%lld games, %s vs %s, %zu openings, %d threads\n", count, players[0].name.c_str(),
+           players[1].name.c_str(), openings.size(), pool.size());
+
+    // Batches bound the number of finished games waiting to be written in order.
+    size_t batchSize = size_t(pool.size()) * 4;
+    vector<GameRecord> records(batchSize);
+    Score score;
+    std::uint64_t nodes[2] = { 0, 0 };
+    double        searchSecs[2] = { 0, 0 };
+    unsigned long long plies = 0;
+    vector<pair<string, unsigned long long>> terminations;
+    auto t0 = Clock::now();
+
+    for (size_t first = 0; first < size_t(count); first += batchSize) {
+        size_t n = min(batchSize, size_t(count) - first);
+        pool.run(n, [&](size_t i, int worker) {
+            playGame(first + i, match, *workers[size_t(worker)], records[i]);
+        });
+
+        for (size_t i = 0; i < n; ++i) {
+            const GameRecord& r = records[i];
+            if (r.result == GameResult::Draw) {
+                ++score.draws;
+            } else if ((r.result == GameResult::WhiteWins) == r.aWhite) {
+                ++score.wins;
+            } else {
+                ++score.losses;
+            }
+            for (int p = 0; p < 2; ++p) {
+                nodes[p]      += r.nodes[p];
+                searchSecs[p] += r.seconds[p];
+            }
+            plies += r.plies;
+            auto it = find_if(terminations.begin(), terminations.end(),
+                              [&](const auto& t) { return t.first == r.termination; });
+            if (it == terminations.end()) terminations.push_back({ r.termination, 1 });
+            else                          ++it->second;
+            if (pgnFile) fputs(r.pgn.c_str(), pgnFile);
+        }
+        printf("  %6llu/%lld  ", score.games(), count);
+        printScore(score);
+        printf("\n");
+        fflush(stdout);
+    }
+    if (pgnFile) fclose(pgnFile);
+
+    double secs = secondsSince(t0);
+    printf("\n%llu games in %.1fs: %.0f games/hour, %.1f plies/game\n", score.games(), secs,
+           score.games() / secs * 3600, double(plies) / score.games());
+    for (int p = 0; p < 2; ++p) {
+        const Player& pl = players[p];
+        string limits;
+        if (pl.limits.depth < kMaxPly - 1) limits += " depth " + to_string(pl.limits.depth);
+        if (pl.limits.nodes)      limits += " nodes " + to_string(pl.limits.nodes);
+        if (pl.limits.movetimeMs) limits += " movetime " + to_string(pl.limits.movetimeMs) + "ms";
+        if (!pl.net.empty())      limits += " net " + pl.net;
+        printf("  %-8s%s  hash %d MB  %.0f nps\n", pl.name.c_str(), limits.c_str(), pl.hashMB,
+               searchSecs[p] > 0 ? nodes[p] / searchSecs[p] : 0.0);
+    }
+    printf("  endings:");
+    for (size_t i = 0; i < terminations.size(); ++i)
+        printf("%s %s %llu", i ? "," : "", terminations[i].first.c_str(), terminations[i].second);
+    printf("\n%s vs %s: ", players[0].name.c_str(), players[1].name.c_str());
+    printScore(score);
+    printf(" (95%%)\n");
+    return 0;
+}
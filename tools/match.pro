@@ -0,0 +1,13 @@
+# Engine-versus-engine match runner (no Qt): plays games in parallel from an
+# opening list, writes PGN and reports score, Elo and games/hour.
+#   qmake tools/match.pro && make && ./match -n 200 -a nodes=40000 -b nodes=20000
+
+TEMPLATE = app
+TARGET   = match
+CONFIG  += console c++17
+CONFIG  -= qt app_bundle
+
+include(../engine.pri)
+
+SOURCES += \
+    match.cpp
@@ -0,0 +1,80 @@
+// NNUE: writes and inspects network files for the NNUE evaluation.
+//
+//   nnue random OUT [SEED]   write a network of random weights (about 20 MB)
+//   nnue eval NET [fen]      evaluate one position with every kernel the CPU runs
+//
+// No trained network ships with the engine; a random one has the right
+// format and cost, which is enough to time the evaluation and to test the
+// plumbing (analyze net FILE, uci FILE, match net=FILE), not to play well.
+// "eval" prints the built-in evaluation next to the network's and checks
+// that every kernel agrees with the plain C++ one.
+
+#include "search.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+static const char* const kStartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+static int usage() {
+    fprintf(stderr, "usage: nnue random OUT [SEED]\n"
+                    "       nnue eval NET [fen]\n");
+    return 2;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) return usage();
+
+    if (!strcmp(argv[1], "random")) {
+        if (argc > 4) return usage();
+        uint64_t seed = argc == 4 ? strtoull(argv[3], nullptr, 10) : 1;
+        string error;
+        if (!nnue::Network::writeRandom(argv[2], seed, &error)) {
+            fprintf(stderr, "nnue: %s\n", error.c_str());
+            return 1;
+        }
+        printf("wrote %s (random weights, seed %llu)\n", argv[2], (unsigned long long)seed);
+        return 0;
+    }
+
+    if (!strcmp(argv[1], "eval")) {
+        nnue::Network net;
+        if (!net.load(argv[2])) {
+            fprintf(stderr, "nnue: %s\n", net.error().c_str());
+            return 1;
+        }
+        string fen;
+        for (int i = 3; i < argc; ++i) {
+            if (!fen.empty()) fen += ' ';
+            fen += argv[i];
+        }
+        if (fen.empty()) fen = kStartFEN;
+        ChessGame game;
+        if (!game.fromFEN(fen)) {
+            fprintf(stderr, "nnue: invalid FEN \"%s\"\n", fen.c_str());
+            return 2;
+        }
+
+        printf("%s\n", fen.c_str());
+        printf("  %-10s %6d cp\n", "built-in", evaluate(game));
+        int reference = 0;
+        bool agree = true;
+        for (nnue::Simd s : { nnue::Simd::Scalar, nnue::Simd::Sse2, nnue::Simd::Avx2 }) {
+            if (s > nnue::bestSimd()) break;
+            nnue::setSimd(s);
+            int score = nnue::evaluate(net, game.state());
+            if (s == nnue::Simd::Scalar) reference = score;
+            agree &= score == reference;
+            printf("  %-10s %6d cp\n", nnue::simdName(s), score);
+        }
+        if (!agree) {
+            fprintf(stderr, "nnue: kernels disagree\n");
+            return 1;
+        }
+        return 0;
+    }
+    return usage();
+}
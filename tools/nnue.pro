@@ -0,0 +1,13 @@
+# NNUE network utility (no Qt): writes random-weight network files and
+# evaluates a position with each SIMD kernel the CPU supports.
+#   qmake tools/nnue.pro && make && ./nnue random net.nnue
+
+TEMPLATE = app
+TARGET   = nnue
+CONFIG  += console c++17
+CONFIG  -= qt app_bundle
+
+include(../engine.pri)
+
+SOURCES += \
+    nnue.cpp
@@ -0,0 +1,176 @@
+// Perft: counts the leaf nodes of the legal move tree to a fixed depth.
+//
+//   perft                            run the reference suite (exit 1 on mismatch)
+//   perft suite [maxNodes]           same, skipping depths above maxNodes leaves
+//   perft <depth> [fen]              count nodes from fen (default: start position)
+//   perft divide <depth> [fen]       per-root-move breakdown
+//
+// The suite is the regression gate for castling, en passant and promotion
+// handling in chess.cpp; the nodes/second figure is the engine's headline
+// move-generation throughput.
+
+#include "chess.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const char* const kStartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+static unsigned long long perft(ChessGame& game, int depth) {
+    MoveList moves;
+    game.generateLegalMoves(moves);
+    if (depth <= 1) return depth == 1 ? moves.size() : 1;
+
+    unsigned long long nodes = 0;
+    for (Move m : moves) {
+        MoveUndo undo;
+        game.makeMove(m, undo);
+        nodes += perft(game, depth - 1);
+        game.unmakeMove(undo);
+    }
+    return nodes;
+}
+
+// ── output helpers ────────────────────────────────────────────────────────────
+using Clock = chrono::steady_clock;
+
+static double secondsSince(Clock::time_point t0) {
+    return chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// ── reference positions ───────────────────────────────────────────────────────
+// Published node counts: the standard perft table positions plus the
+// castling / en passant / promotion edge cases collected on TalkChess.
+struct Reference {
+    const char* name;
+    const char* fen;
+    vector<pair<int, unsigned long long>> nodes;   // (depth, leaf count)
+};
+
+static const Reference kSuite[] = {
+    { "start position", kStartFEN,
+      { {1, 20}, {2, 400}, {3, 8902}, {4, 197281}, {5, 4865609}, {6, 119060324} } },
+    { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      { {1, 48}, {2, 2039}, {3, 97862}, {4, 4085603}, {5, 193690690} } },
+    { "position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+      { {1, 14}, {2, 191}, {3, 2812}, {4, 43238}, {5, 674624}, {6, 11030083} } },
+    { "position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+      { {1, 6}, {2, 264}, {3, 9467}, {4, 422333}, {5, 15833292} } },
+    { "position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+      { {1, 44}, {2, 1486}, {3, 62379}, {4, 2103487}, {5, 89941194} } },
+    { "position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+      { {1, 46}, {2, 2079}, {3, 89890}, {4, 3894594}, {5, 164075551} } },
+    { "illegal ep move #1",         "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1",          { {6, 1134888} } },
+    { "illegal ep move #2",         "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1",         { {6, 1015133} } },
+    { "ep capture checks opponent", "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1",        { {6, 1440467} } },
+    { "short castling gives check", "5k2/8/8/8/8/8/8/4K2R w K - 0 1",             { {6, 661072} } },
+    { "long castling gives check",  "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1",             { {6, 803711} } },
+    { "castle rights",              "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1",  { {4, 1274206} } },
+    { "castling prevented",         "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1",   { {4, 1720476} } },
+    { "promote out of check",       "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1",          { {6, 3821001} } },
+    { "discovered check",           "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1",        { {5, 1004658} } },
+    { "promote to give check",      "4k3/1P6/8/8/8/8/K7/8 w - - 0 1",             { {6, 217342} } },
+    { "underpromote to check",      "8/P1k5/K7/8/8/8/8/8 w - - 0 1",              { {6, 92683} } },
+    { "self stalemate",             "K1k5/8/P7/8/8/8/8/8 w - - 0 1",              { {6, 2217} } },
+    { "stalemate and checkmate #1", "8/k1P5/8/1K6/8/8/8/8 w - - 0 1",             { {7, 567584} } },
+    { "stalemate and checkmate #2", "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1",          { {4, 23527} } },
+};
+
+static int runSuite(unsigned long long maxNodes) {
+    unsigned long long total = 0;
+    int failures = 0;
+    auto t0 = Clock::now();
+
+    for (const auto& ref : kSuite) {
+        ChessGame game;
+        if (!game.fromFEN(ref.fen)) {
+            printf("%-28s  bad FEN\n", ref.name);
+            ++failures;
+            continue;
+        }
+        // Deepest listed depth within the node budget.
+        int depth = 0;
+        unsigned long long expected = 0;
+        for (const auto& [d, n] : ref.nodes)
+            if (n <= maxNodes) { depth = d; expected = n; }
+        if (depth == 0) continue;
+
+        auto t1 = Clock::now();
+        unsigned long long nodes = perft(game, depth);
+        double secs = secondsSince(t1);
+        bool ok = nodes == expected;
+        failures += !ok;
+        total += nodes;
+        printf("%-28s  depth %d  %12llu  %s", ref.name, depth, nodes, ok ? "ok  " : "FAIL");
+        if (!ok) printf(" (expected %llu)", expected);
+        printf("  %7.3fs  %6.2f Mnps\n", secs, nodes / secs / 1e6);
+    }
+
+    double secs = secondsSince(t0);
+    printf("\n%llu nodes in %.3fs, %.2f Mnps — %d failure(s)\n",
+           total, secs, total / secs / 1e6, failures);
+    return failures ? 1 : 0;
+}
+
+static int usage() {
+    fprintf(stderr,
+            "usage: perft [suite [maxNodes]]\n"
+            "       perft <depth> [fen]\n"
+            "       perft divide <depth> [fen]\n");
+    return 2;
+}
+
+// FEN arrives either as one quoted argument or split over several.
+static string joinArgs(int argc, char* argv[], int first) {
+    string fen;
+    for (int i = first; i < argc; ++i) {
+        if (!fen.empty()) fen += ' ';
+        fen += argv[i];
+    }
+    return fen.empty() ? kStartFEN : fen;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) return runSuite(5000000);
+    if (!strcmp(argv[1], "suite"))
+        return runSuite(argc > 2 ? strtoull(argv[2], nullptr, 10) : 5000000);
+
+    bool divide = !strcmp(argv[1], "divide");
+    int  arg    = divide ? 2 : 1;
+    if (arg >= argc) return usage();
+    int depth = atoi(argv[arg]);
+    if (depth < 1) return usage();
+
+    ChessGame game;
+    string fen = joinArgs(argc, argv, arg + 1);
+    if (!game.fromFEN(fen)) {
+        fprintf(stderr, "perft: invalid FEN \"%s\"\n", fen.c_str());
+        return 2;
+    }
+
+    auto t0 = Clock::now();
+    unsigned long long nodes = 0;
+    if (divide) {
+        MoveList moves;
+        game.generateLegalMoves(moves);
+        for (Move m : moves) {
+            MoveUndo undo;
+            game.makeMove(m, undo);
+            unsigned long long n = perft(game, depth - 1);
+            game.unmakeMove(undo);
+            printf("%s: %llu\n", m.uci().c_str(), n);
+            nodes += n;
+        }
+        printf("\n");
+    } else {
+        nodes = perft(game, depth);
+    }
+    double secs = secondsSince(t0);
+    printf("nodes %llu  time %.3fs  nps %.0f\n", nodes, secs, nodes / secs);
+    return 0;
+}
@@ -0,0 +1,13 @@
+# Headless perft harness (no Qt): move-generation regression gate and
+# throughput benchmark. `make check` runs the reference suite.
+#   qmake tools/perft.pro && make && ./perft
+
+TEMPLATE = app
+TARGET   = perft
+CONFIG  += console c++17 testcase
+CONFIG  -= qt app_bundle
+
+include(../engine.pri)
+
+SOURCES += \
+    perft.cpp
@@ -0,0 +1,207 @@
+// PGN replay: validates game archives by playing every game through the
+// rules engine, on all cores.
+//
+//   pgn [-q] [-j threads] [-o results.tsv] file.pgn ...
+//   pgn scale [maxThreads] file.pgn
+//
+// Each file is memory-mapped and cut into chunks at game boundaries; a
+// work-stealing pool replays the chunks, each worker with its own
+// ChessGame, and the per-game results are merged back in input order.
+// Memory use is bounded by one batch of chunks, whatever the file size.
+//
+// Games that do not replay are reported as
+// "file:line: game N (White - Black): reason", with the line of the
+// offending move; -q prints only the totals. -o writes one tab-separated
+// line per game: index, first line, ok/illegal, result, plies, final FEN
+// and the error if any. The exit status is 1 if any game failed.
+//
+// "scale" replays the file with 1, 2, 4, ... threads up to maxThreads
+// (default: the hardware thread count) and prints games/second for each.
+
+#include "mappedfile.h"
+#include "pgn.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+static double secondsSince(Clock::time_point t0) {
+    return chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// What is kept of a game once its worker moves on.
+struct GameRecord {
+    unsigned line      = 0;   // first line of the game
+    int      plies     = 0;
+    string   result;          // termination marker or Result tag, else "*"
+    string   fen;             // position after the last legal move
+    unsigned errorLine = 0;
+    string   error;           // empty if the game replayed cleanly
+    string   players;         // "White - Black", only kept for failed games
+};
+
+// Per-thread scratch state, reused for every game the thread replays.
+struct Worker {
+    ChessGame game;
+    PgnGame   pgn;
+    PgnReplay replay;
+};
+
+struct Totals {
+    unsigned long long games = 0, plies = 0, failed = 0, bytes = 0;
+};
+
+struct Output {
+    bool  quiet = false;
+    FILE* tsv   = nullptr;
+};
+
+static void replayChunk(const PgnChunk& chunk, Worker& w, vector<GameRecord>& out) {
+    PgnReader reader(chunk.text, chunk.firstLine);
+    while (reader.next(w.pgn)) {
+        replayPgn(w.pgn, w.game, w.replay);
+        GameRecord r;
+        r.line   = w.pgn.line;
+        r.plies  = w.replay.plies;
+        // A game cut short by an error still has its Result tag.
+        string_view result = !w.replay.result.empty() ? w.replay.result : w.pgn.tag("Result");
+        r.result = result.empty() ? "*" : string(result);
+        r.fen    = w.game.toFEN();
+        if (!w.replay.ok()) {
+            r.errorLine = w.replay.errorLine;
+            r.error     = move(w.replay.error);
+            r.players   = string(w.pgn.tag("White")) + " - " + string(w.pgn.tag("Black"));
+        }
+        out.push_back(move(r));
+    }
+}
+
+static void replayFile(const char* path, string_view text, ThreadPool& pool,
+                       vector<Worker>& workers, const Output& output, Totals& totals) {
+    // Enough chunks per thread for stealing to even out long and short
+    // games, but not so small that the per-chunk overhead shows.
+    size_t threads    = size_t(pool.size());
+    size_t chunkBytes = clamp<size_t>(text.size() / (threads * 32), 64 << 10, 4 << 20);
+    vector<PgnChunk> chunks = splitPgn(text, chunkBytes);
+
+    // Batches of chunks bound how many results wait to be written in order.
+    size_t batchSize = threads * 8;
+    vector<vector<GameRecord>> results(batchSize);
+    unsigned long long index = 0;
+    for (size_t first = 0; first < chunks.size(); first += batchSize) {
+        size_t count = min(batchSize, chunks.size() - first);
+        pool.run(count, [&](size_t i, int worker) {
+            results[i].clear();
+            replayChunk(chunks[first + i], workers[size_t(worker)], results[i]);
+        });
+
+        for (size_t i = 0; i < count; ++i)
+            for (const GameRecord& r : results[i]) {
+                ++index;
+                totals.plies += r.plies;
+                bool ok = r.error.empty();
+                totals.failed += !ok;
+                if (!ok && !output.quiet)
+                    printf("%s:%u: game %llu (%s): %s\n", path, r.errorLine, index,
+                           r.players.c_str(), r.error.c_str());
+                if (output.tsv)
+                    fprintf(output.tsv, "%llu\t%u\t%s\t%s\t%d\t%s\t%s\n", index, r.line,
+                            ok ? "ok" : "illegal", r.result.c_str(), r.plies, r.fen.c_str(),
+                            r.error.c_str());
+            }
+    }
+    totals.games += index;
+    totals.bytes += text.size();
+}
+
+static void printTotals(const Totals& t, double secs) {
+    printf("%llu games, %llu plies, %llu illegal  %.3fs  %.0f games/s  %.2f Mplies/s  %.1f MB/s\n",
+           t.games, t.plies, t.failed, secs, t.games / secs, t.plies / secs / 1e6,
+           t.bytes / secs / 1e6);
+}
+
+static int scale(int maxThreads, const char* path) {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        fprintf(stderr, "pgn: %s\n", file.error().c_str());
+        return 2;
+    }
+    printf("%s: %.1f MB, up to %d threads (%u hardware)\n", path, file.size() / 1e6, maxThreads,
+           thread::hardware_concurrency());
+    printf("  %8s %10s %12s %10s\n", "threads", "seconds", "games/s", "speedup");
+
+    Output quiet;
+    quiet.quiet = true;
+    double base = 0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool     pool(threads);
+        vector<Worker> workers(size_t(pool.size()));
+        Totals         totals;
+        auto t0 = Clock::now();
+        replayFile(path, file.view(), pool, workers, quiet, totals);
+        double secs = secondsSince(t0);
+        double rate = totals.games / secs;
+        if (threads == 1) base = rate;
+        printf("  %8d %10.3f %12.0f %9.2fx\n", threads, secs, rate, rate / base);
+        fflush(stdout);
+    }
+    return 0;
+}
+
+static int usage() {
+    fprintf(stderr,
+            "usage: pgn [-q] [-j threads] [-o results.tsv] file.pgn ...\n"
+            "       pgn scale [maxThreads] file.pgn\n");
+    return 2;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 3 && !strcmp(argv[1], "scale")) {
+        int maxThreads = argc > 3 ? atoi(argv[2]) : int(max(1u, thread::hardware_concurrency()));
+        if (maxThreads < 1) return usage();
+        return scale(maxThreads, argv[argc - 1]);
+    }
+
+    Output      output;
+    int         threads = 0;
+    const char* tsvPath = nullptr;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg) {
+        if      (!strcmp(argv[arg], "-q"))                     output.quiet = true;
+        else if (!strcmp(argv[arg], "-j") && arg + 1 < argc)   threads = atoi(argv[++arg]);
+        else if (!strcmp(argv[arg], "-o") && arg + 1 < argc)   tsvPath = argv[++arg];
+        else return usage();
+    }
+    if (arg >= argc || threads < 0) return usage();
+
+    if (tsvPath && !(output.tsv = fopen(tsvPath, "w"))) {
+        fprintf(stderr, "pgn: cannot write %s\n", tsvPath);
+        return 2;
+    }
+
+    ThreadPool     pool(threads);
+    vector<Worker> workers(size_t(pool.size()));
+    Totals         totals;
+    auto t0 = Clock::now();
+    for (; arg < argc; ++arg) {
+        MappedFile file(argv[arg]);
+        if (!file.isOpen()) {
+            fprintf(stderr, "pgn: %s\n", file.error().c_str());
+            return 2;
+        }
+        replayFile(argv[arg], file.view(), pool, workers, output, totals);
+    }
+    if (output.tsv) fclose(output.tsv);
+
+    printTotals(totals, secondsSince(t0));
+    return totals.failed ? 1 : 0;
+}
@@ -0,0 +1,13 @@
+# PGN archive validation (no Qt): replays every game through the rules
+# engine and reports illegal games with their line numbers.
+#   qmake tools/pgn.pro && make && ./pgn games.pgn
+
+TEMPLATE = app
+TARGET   = pgn
+CONFIG  += console c++17
+CONFIG  -= qt app_bundle
+
+include(../engine.pri)
+
+SOURCES += \
+    pgn.cpp
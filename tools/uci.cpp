@@ -0,0 +1,311 @@
+// UCI: the engine as a Universal Chess Interface process, for tournament
+// managers, GUIs and analysis scripts.
+//
+//   uci [NETWORK]  then speak UCI on stdin / stdout
+//
+// A network file given on the command line is mapped at startup and used
+// for evaluation (nnue.h), as is one set later through the EvalFile option;
+// without one, or with EvalFile <empty>, the built-in evaluation is used.
+//
+// Commands: uci, isready, ucinewgame, setoption name Hash|Threads value N,
+// setoption name EvalFile value PATH,
+// position startpos|fen <fen> [moves m1 m2 ...], go [depth N] [nodes N]
+// [movetime MS] [wtime MS] [btime MS] [winc MS] [binc MS] [movestogo N]
+// [infinite], stop, quit. Unknown commands are ignored, as UCI asks.
+//
+// Input is read on the main thread and every search runs on a thread of its
+// own, so "stop", "isready" and "quit" are answered while a search is still
+// going: stop interrupts it at the next node. "go infinite" only reports
+// its best move once stopped, even if the search ends by itself.
+
+#include "search.h"
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static const char* const kStartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+constexpr int kDefaultHashMB = 16, kMaxHashMB = 4096;
+constexpr int kMaxThreads    = 256;
+
+// Both the input thread and the search thread write to stdout; each line
+// goes out whole and is flushed at once, since the other end is a pipe.
+static mutex gOutput;
+
+static void send(const char* format, ...) {
+    lock_guard<mutex> lock(gOutput);
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    putchar('\n');
+    fflush(stdout);
+}
+
+static vector<string> split(const string& line) {
+    vector<string> words;
+    size_t i = 0;
+    while (i < line.size()) {
+        size_t begin = line.find_first_not_of(" \t\r", i);
+        if (begin == string::npos) break;
+        size_t end = min(line.find_first_of(" \t\r", begin), line.size());
+        words.push_back(line.substr(begin, end - begin));
+        i = end;
+    }
+    return words;
+}
+
+static string formatScore(int score) {
+    if (!isMateScore(score)) return "cp " + to_string(score);
+    int plies = kMateScore - abs(score);
+    return "mate " + to_string(score > 0 ? (plies + 1) / 2 : -(plies + 1) / 2);
+}
+
+// Moves arrive in coordinate notation ("e2e4", "e7e8q"); only legal ones match.
+static Move findMove(const ChessGame& game, const string& uci) {
+    MoveList moves;
+    game.generateLegalMoves(moves);
+    for (Move m : moves)
+        if (m.uci() == uci) return m;
+    return Move::none();
+}
+
+class Engine {
+public:
+    Engine() : tt_(kDefaultHashMB), searcher_(tt_, 1) {}
+    ~Engine() { finishSearch(); }
+
+    // Returns false on "quit".
+    bool handle(const string& line);
+    // An empty path or "<empty>" goes back to the built-in evaluation, and
+    // so does a network that fails to load (see networkError()).
+    bool loadNetwork(const string& path);
+    const string& networkError() const { return net_.error(); }
+
+private:
+    void position(const vector<string>& words);
+    void go(const vector<string>& words);
+    void setOption(const vector<string>& words);
+    void finishSearch();   // stops a running search and waits for its bestmove
+    void printIteration(const SearchResult& r) const;
+
+    TranspositionTable tt_;
+    ParallelSearcher   searcher_;
+    ChessGame          game_;
+    nnue::Network      net_;
+    thread             search_;
+
+    // "go infinite" holds its bestmove until stop; stop_ is what it waits on.
+    mutex              stopMutex_;
+    condition_variable stopSignal_;
+    bool               stop_ = false;
+};
+
+bool Engine::handle(const string& line) {
+    vector<string> words = split(line);
+    if (words.empty()) return true;
+    const string& cmd = words[0];
+
+    if (cmd == "uci") {
+        send("id name ChessGame");
+        send("id author ChessGame developers");
+        send("option name Hash type spin default %d min 1 max %d", kDefaultHashMB, kMaxHashMB);
+        send("option name Threads type spin default 1 min 1 max %d", kMaxThreads);
+        send("option name EvalFile type string default <empty>");
+        send("uciok");
+    } else if (cmd == "isready") {
+        send("readyok");
+    } else if (cmd == "ucinewgame") {
+        finishSearch();
+        tt_.clear();
+        game_ = ChessGame();
+    } else if (cmd == "setoption") {
+        finishSearch();
+        setOption(words);
+    } else if (cmd == "position") {
+        finishSearch();
+        position(words);
+    } else if (cmd == "go") {
+        finishSearch();
+        go(words);
+    } else if (cmd == "stop") {
+        finishSearch();
+    } else if (cmd == "quit") {
+        finishSearch();
+        return false;
+    }
+    return true;
+}
+
+// position startpos | fen <up to six fields> [moves ...]. A bad FEN keeps
+// the previous position; an illegal move keeps the moves before it.
+void Engine::position(const vector<string>& words) {
+    size_t i = 1;
+    string fen;
+    if (i < words.size() && words[i] == "startpos") {
+        fen = kStartFEN;
+        ++i;
+    } else if (i < words.size() && words[i] == "fen") {
+        for (++i; i < words.size() && words[i] != "moves"; ++i) {
+            if (!fen.empty()) fen += ' ';
+            fen += words[i];
+        }
+    } else {
+        return;
+    }
+
+    ChessGame game;
+    if (!game.fromFEN(fen)) {
+        send("info string invalid FEN \"%s\"", fen.c_str());
+        return;
+    }
+    if (i < words.size() && words[i] == "moves")
+        for (++i; i < words.size(); ++i) {
+            Move m = findMove(game, words[i]);
+            if (m == Move::none()) {
+                send("info string illegal move %s", words[i].c_str());
+                break;
+            }
+            // The game keeps the keys it needs for repetitions itself.
+            MoveUndo undo;
+            game.makeMove(m, undo);
+        }
+    game_ = game;
+}
+
+void Engine::go(const vector<string>& words) {
+    SearchLimits limits;
+    int  time[2] = { 0, 0 }, inc[2] = { 0, 0 }, movesToGo = 0;
+    bool infinite = false;
+    for (size_t i = 1; i < words.size(); ++i) {
+        const string& w = words[i];
+        bool   hasValue = i + 1 < words.size();
+        long long value = hasValue ? atoll(words[i + 1].c_str()) : 0;
+        if      (w == "infinite")  infinite = true;
+        else if (!hasValue)        break;
+        else if (w == "depth")     limits.depth      = int(value), ++i;
+        else if (w == "nodes")     limits.nodes      = uint64_t(max(0LL, value)), ++i;
+        else if (w == "movetime")  limits.movetimeMs = int(value), ++i;
+        else if (w == "wtime")     time[0]           = int(value), ++i;
+        else if (w == "btime")     time[1]           = int(value), ++i;
+        else if (w == "winc")      inc[0]            = int(value), ++i;
+        else if (w == "binc")      inc[1]            = int(value), ++i;
+        else if (w == "movestogo") movesToGo         = int(value), ++i;
+    }
+    limits.depth = clamp(limits.depth, 1, kMaxPly - 1);
+
+    // On a clock, spend an even share of the remaining time (over 30 moves
+    // without a move count) plus most of the increment, and always keep a
+    // margin for the GUI's own latency.
+    int us = game_.getCurrentTurn() == PieceColor::White ? 0 : 1;
+    if (!infinite && !limits.movetimeMs && time[us] > 0) {
+        int left   = time[us];
+        int budget = left / (movesToGo > 0 ? movesToGo : 30) + inc[us] * 3 / 4;
+        limits.movetimeMs = max(1, min(budget, left - min(50, left / 2)));
+    }
+
+    {
+        lock_guard<mutex> lock(stopMutex_);
+        stop_ = false;
+    }
+    // Here rather than on the search thread: a "stop" read right after
+    // this "go" must reach the searcher even if run() has not begun yet.
+    searcher_.prepare();
+    // The search thread gets its own copy of the position: a later
+    // "position" never touches a game being searched.
+    search_ = thread([this, root = game_, limits, infinite] {
+        SearchResult r = searcher_.run(root, limits,
+                                       [this](const SearchResult& it) { printIteration(it); });
+        if (infinite) {
+            unique_lock<mutex> lock(stopMutex_);
+            stopSignal_.wait(lock, [this] { return stop_; });
+        }
+        if (r.bestMove == Move::none()) {
+            send("bestmove 0000");
+        } else if (r.pv.size() > 1) {
+            send("bestmove %s ponder %s", r.bestMove.uci().c_str(), r.pv[1].uci().c_str());
+        } else {
+            send("bestmove %s", r.bestMove.uci().c_str());
+        }
+    });
+}
+
+void Engine::finishSearch() {
+    if (!search_.joinable()) return;
+    searcher_.stop();
+    {
+        lock_guard<mutex> lock(stopMutex_);
+        stop_ = true;
+    }
+    stopSignal_.notify_all();
+    search_.join();
+}
+
+// setoption name <Hash|Threads> value <N>, or name EvalFile value <path>
+// (which may contain spaces); names are case-insensitive.
+void Engine::setOption(const vector<string>& words) {
+    if (words.size() < 4 || words[1] != "name" || words[3] != "value") return;
+    string name = words[2];
+    for (char& ch : name) ch = char(tolower(static_cast<unsigned char>(ch)));
+    string text;
+    for (size_t i = 4; i < words.size(); ++i) text += (i > 4 ? " " : "") + words[i];
+    int value = atoi(text.c_str());
+    if (name == "hash" && !text.empty()) {
+        tt_.resize(size_t(clamp(value, 1, kMaxHashMB)));
+    } else if (name == "threads" && !text.empty()) {
+        searcher_.setThreads(clamp(value, 1, kMaxThreads));
+    } else if (name == "evalfile") {
+        if (text.empty() || text == "<empty>") {
+            loadNetwork(text);
+            send("info string built-in evaluation");
+        } else if (loadNetwork(text)) {
+            send("info string NNUE network %s (%s)", net_.path().c_str(), nnue::simdName(nnue::simd()));
+        } else {
+            send("info string %s", networkError().c_str());
+        }
+    } else {
+        send("info string unknown option %s", words[2].c_str());
+    }
+}
+
+bool Engine::loadNetwork(const string& path) {
+    searcher_.setNetwork(nullptr);
+    if (path.empty() || path == "<empty>") return true;
+    if (!net_.load(path)) return false;
+    searcher_.setNetwork(&net_);
+    return true;
+}
+
+void Engine::printIteration(const SearchResult& r) const {
+    string pv;
+    for (Move m : r.pv) pv += ' ' + m.uci();
+    send("info depth %d score %s nodes %llu nps %llu time %.0f hashfull %d pv%s", r.depth,
+         formatScore(r.score).c_str(), (unsigned long long)r.nodes, (unsigned long long)r.nps,
+         r.seconds * 1000, r.hashfull, pv.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 2) {
+        fprintf(stderr, "usage: uci [NETWORK]\n");
+        return 2;
+    }
+    Engine engine;
+    if (argc == 2 && !engine.loadNetwork(argv[1])) {
+        fprintf(stderr, "uci: %s\n", engine.networkError().c_str());
+        return 1;
+    }
+    string line;
+    while (getline(cin, line))
+        if (!engine.handle(line)) break;
+    return 0;
+}
@@ -0,0 +1,13 @@
+# UCI engine process (no Qt): speaks the Universal Chess Interface on
+# stdin/stdout so tournament managers and scripts can drive the engine.
+#   qmake tools/uci.pro && make && ./uci
+
+TEMPLATE = app
+TARGET   = uci
+CONFIG  += console c++17
+CONFIG  -= qt app_bundle
+
+include(../engine.pri)
+
+SOURCES += \
+    uci.cpp